@@ -1,24 +1,193 @@
 #include "../include/module.h"
 #include "../include/floorplanner.h"
+#include "../include/jobServer.h"
+#include "../include/batchRunner.h"
+#include "../include/paretoArchive.h"
+#include "../include/islandModel.h"
+#include "../include/allocationCounter.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <thread>
+#include <cstring>
 
-
+// anneals a design once per engine, and once as a speculative chain, and fails if
+// any iteration of the annealing thread touched the heap
+static int checkAllocations(const char* blockPath, const char* netPath, int iterations)
+{
+    if (!countsAllocations()) {
+        std::cerr << "Allocation counting is disabled, reconfigure with -DFP_COUNT_ALLOCATIONS=ON" << std::endl;
+        return 1;
+    }
+    int failures = 0;
+    const char* engines[] = {"fixed", "generic", "speculative"};
+    for (int engine = 0; engine < 3; engine++) {
+        std::ifstream input_blk(blockPath), input_net(netPath);
+        if (!input_blk || !input_net) {
+            std::cerr << "Cannot open the input files \"" << blockPath << "\" and \"" << netPath << "\"" << std::endl;
+            return 1;
+        }
+        Floorplanner fp(0.5, input_blk, input_net);
+        fp.setSeed(1);
+        fp.setVerbose(false);
+        fp.setOutputPath("");
+        fp.setRefineThreads(0);
+        fp.setFixedEngine(engine != 1);
+        fp.setSpeculativeThreads(engine == 2 ? 2 : 0);
+        fp.setIterationWindow(0, iterations);
+        fp.floorplan();
+        const FloorplanResult& result = fp.getResult();
+        // the speculative count includes its helper threads
+        std::cout << engines[engine] << " engine: " << result.allocations
+                  << " allocations in " << result.iterations << " iterations" << std::endl;
+        if (result.allocations != 0) failures++;
+    }
+    return failures == 0 ? 0 : 1;
+}
 
 int main(int argc, char** argv)
 {
+    // server mode: ./Floorplanner --serve <socket> [workers]
+    if (argc >= 3 && strcmp(argv[1], "--serve") == 0) {
+        int workers = argc >= 4 ? std::stoi(argv[3]) : (int)std::thread::hardware_concurrency();
+        JobServer server(argv[2], workers);
+        return server.run();
+    }
+
+    // batch mode: ./Floorplanner --batch <manifest> [threads]
+    if (argc >= 3 && strcmp(argv[1], "--batch") == 0) {
+        int threads = argc >= 4 ? std::stoi(argv[3]) : (int)std::thread::hardware_concurrency();
+        return runBatch(argv[2], threads) == 0 ? 0 : 1;
+    }
+
+    // pareto mode: ./Floorplanner --pareto [--seed <n>] <input block file> <input net file> <output file> [replicas] [budget]
+    if (argc >= 5 && strcmp(argv[1], "--pareto") == 0) {
+        bool seeded = strcmp(argv[2], "--seed") == 0;
+        int at = seeded ? 4 : 2;
+        if (argc >= at + 3) {
+            unsigned int paretoSeed = seeded ? std::stoul(argv[3]) : 1;
+            int replicas = argc >= at + 4 ? std::stoi(argv[at + 3]) : 1;
+            double budget = argc >= at + 5 ? std::stod(argv[at + 4]) : 0;
+            return runPareto(argv[at], argv[at + 1], argv[at + 2], replicas, budget,
+                             (int)std::thread::hardware_concurrency(), paretoSeed);
+        }
+    }
+
+    // island coordinator: ./Floorplanner --island [--seed <n>] <address> <islands> <local workers> <alpha>
+    //     <input block file> <input net file> <output file> [epochs] [fastsa|lam]
+    if (argc >= 9 && strcmp(argv[1], "--island") == 0) {
+        bool seeded = strcmp(argv[2], "--seed") == 0;
+        int at = seeded ? 4 : 2;
+        bool knownSchedule = argc < at + 9 || strcmp(argv[at + 8], "fastsa") == 0 || strcmp(argv[at + 8], "lam") == 0;
+        if (argc >= at + 7 && knownSchedule) {
+            FloorplanJob job;
+            job.alpha = std::stod(argv[at + 3]);
+            job.blockPath = argv[at + 4];
+            job.netPath = argv[at + 5];
+            job.outputPath = argv[at + 6];
+            // island i is seeded with seed + i
+            job.seed = seeded ? std::stoul(argv[3]) : time(nullptr);
+            int epochs = argc >= at + 8 ? std::stoi(argv[at + 7]) : ISLAND_EPOCHS;
+            if (argc >= at + 9 && strcmp(argv[at + 8], "lam") == 0) job.schedule = LAM_SCHEDULE;
+            // the reported floorplan stays the packing of the best island tree, as refinement is opt-in
+            return runIslands(argv[at], std::stoi(argv[at + 1]), std::stoi(argv[at + 2]), argv[0], job, epochs, 0);
+        }
+    }
+
+    // island worker: ./Floorplanner --island-worker <address>
+    if (argc >= 3 && strcmp(argv[1], "--island-worker") == 0) {
+        return runIslandWorker(argv[2]);
+    }
+
+    // allocation check: ./Floorplanner --check-allocations <input block file> <input net file> [iterations]
+    if (argc >= 4 && strcmp(argv[1], "--check-allocations") == 0) {
+        return checkAllocations(argv[2], argv[3], argc >= 5 ? std::stoi(argv[4]) : 100000);
+    }
+
+    // client mode: ./Floorplanner --submit <socket> <job line...> | shutdown
+    if (argc >= 4 && strcmp(argv[1], "--submit") == 0) {
+        std::string request = argv[3];
+        for (int i = 4; i < argc; i++) {
+            request += " ";
+            request += argv[i];
+        }
+        std::string response;
+        if (!submitRequest(argv[2], request, response)) {
+            std::cerr << "Cannot reach the server at \"" << argv[2] << "\"" << std::endl;
+            exit(1);
+        }
+        std::cout << response << std::endl;
+        return response.compare(0, 2, "OK") == 0 ? 0 : 1;
+    }
+
+    // seed, net model, schedule, start, cache, speculation and refinement options may precede the positional arguments of a single run
+    unsigned int seed = time(nullptr);
+    NetModel netModel;
+    ScheduleKind schedule = FAST_SA_SCHEDULE;
+    bool constructiveStart = true;
+    bool evaluationCache = true;
+    bool stayInOutline = false;
+    // an option given a value it does not take prints the usage
+    bool validOptions = true;
+    int speculativeThreads = 0;
+    int refineThreads = 0;
+    int first = 1;
+    while (first + 1 < argc && strncmp(argv[first], "--", 2) == 0) {
+        if (strcmp(argv[first], "--seed") == 0) {
+            seed = std::stoul(argv[first + 1]);
+        }
+        else if (strcmp(argv[first], "--supply-weight") == 0) {
+            netModel.supplyWeight = std::stod(argv[first + 1]);
+        }
+        else if (strcmp(argv[first], "--fanout-degree") == 0) {
+            netModel.highFanoutDegree = std::stoi(argv[first + 1]);
+        }
+        else if (strcmp(argv[first], "--fanout-weight") == 0) {
+            netModel.highFanoutWeight = std::stod(argv[first + 1]);
+        }
+        else if (strcmp(argv[first], "--fanout-model") == 0) {
+            netModel.approximateHighFanout = strcmp(argv[first + 1], "chipbox") == 0;
+            validOptions = validOptions && (netModel.approximateHighFanout || strcmp(argv[first + 1], "exact") == 0);
+        }
+        else if (strcmp(argv[first], "--schedule") == 0) {
+            schedule = strcmp(argv[first + 1], "lam") == 0 ? LAM_SCHEDULE : FAST_SA_SCHEDULE;
+            validOptions = validOptions && (schedule == LAM_SCHEDULE || strcmp(argv[first + 1], "fastsa") == 0);
+        }
+        else if (strcmp(argv[first], "--refine-threads") == 0) {
+            refineThreads = std::stoi(argv[first + 1]);
+        }
+        else if (strcmp(argv[first], "--initial") == 0) {
+            constructiveStart = strcmp(argv[first + 1], "complete") != 0;
+        }
+        else if (strcmp(argv[first], "--speculate") == 0) {
+            speculativeThreads = std::stoi(argv[first + 1]);
+        }
+        else if (strcmp(argv[first], "--stay-in-outline") == 0) {
+            stayInOutline = strcmp(argv[first + 1], "on") == 0;
+            validOptions = validOptions && (stayInOutline || strcmp(argv[first + 1], "off") == 0);
+        }
+        else if (strcmp(argv[first], "--eval-cache") == 0) {
+            evaluationCache = strcmp(argv[first + 1], "off") != 0;
+        }
+        else {
+            break;
+        }
+        first += 2;
+    }
+    validOptions = validOptions && netModel.isValid();
+    argc -= first - 1;
+    argv += first - 1;
+
     std::ifstream input_blk, input_net;
     std::ofstream output;
 
     double alpha;
 
-    if (argc == 5) {
+    if (validOptions && (argc == 5 || argc == 6)) {
         alpha = std::stod(argv[1]);
         input_blk.open(argv[2], std::ios::in);
         input_net.open(argv[3], std::ios::in);
         output.open(argv[4], std::ios::out);
-        srand(time(nullptr));
         if (!input_blk) {
             std::cerr << "Cannot open the input file \"" << argv[2]
                  << "\". The program will be terminated..." << std::endl;
@@ -34,18 +203,47 @@ int main(int argc, char** argv)
                  << "\". The program will be terminated..." << std::endl;
             exit(1);
         }
+        output.close();
     }
     else {
-        std::cerr << "Usage: ./Floorplanner <alpha> <input block file> " <<
-                "<input net file> <output file>" << std::endl;
+        std::cerr << "Usage: ./Floorplanner [--seed <n>] [--supply-weight <w>] [--fanout-degree <pins>] [--fanout-weight <w>] "
+                "[--fanout-model exact|chipbox] [--schedule fastsa|lam] [--initial cluster|complete] "
+                "[--eval-cache on|off] [--stay-in-outline on|off] [--speculate <threads>] [--refine-threads <n>] <alpha> <input block file> " <<
+                "<input net file> <output file> [snapshot file]" << std::endl;
+        std::cerr << "       --speculate <threads> gives the same floorplan for any thread count, but not the "
+                "one a run without it gives for the same seed" << std::endl;
+        std::cerr << "       --refine-threads <n> (default 0, off) polishes the result by moving blocks off the "
+                "B*-tree; the report then ends with a \"refined <moves>\" line" << std::endl;
+        std::cerr << "       the weights must be at least 0 and --fanout-degree 0 (off) or at least 2" << std::endl;
+        std::cerr << "       ./Floorplanner --serve <socket> [workers]" << std::endl;
+        std::cerr << "       ./Floorplanner --batch <manifest> [threads]" << std::endl;
+        std::cerr << "       ./Floorplanner --pareto [--seed <n>] <input block file> <input net file> "
+                "<output file> [replicas] [budget]" << std::endl;
+        std::cerr << "       ./Floorplanner --island [--seed <n>] <address> <islands> <local workers> <alpha> "
+                "<input block file> <input net file> <output file> [epochs] [fastsa|lam]" << std::endl;
+        std::cerr << "       ./Floorplanner --island-worker <address>" << std::endl;
+        std::cerr << "       ./Floorplanner --check-allocations <input block file> <input net file> "
+                "[iterations]" << std::endl;
+        std::cerr << "       ./Floorplanner --submit <socket> <block file> <net file> "
+                "<alpha> <seed> <budget> <output file> [fastsa|lam] [supply-weight=<w>] [fanout-degree=<pins>] "
+                "[fanout-weight=<w>] [fanout-model=exact|chipbox] [stay-in-outline] | shutdown" << std::endl;
         exit(1);
     }
 
     Floorplanner* fp = new Floorplanner(alpha, input_blk, input_net);
+    fp->setSeed(seed);
+    fp->setNetModel(netModel);
+    fp->setSchedule(schedule);
+    fp->setConstructiveStart(constructiveStart);
+    fp->setEvaluationCache(evaluationCache);
+    fp->setStayInOutline(stayInOutline);
+    fp->setSpeculativeThreads(speculativeThreads);
+    fp->setRefineThreads(refineThreads);
+    fp->setOutputPath(argv[4]);
+    if (argc == 6) fp->setSnapshotPath(argv[5]);
     fp->floorplan();
     //fp->checkPlacementInformation();
-    
+
 
     return 0;
 }
-
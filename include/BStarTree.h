@@ -13,15 +13,29 @@ class BStarTree
 {
 public:
     void buildTree(const std::vector<Block> &blocks);
+    void buildShelves(const std::vector<std::vector<int>> &rows, int blockCount);
     void printTree(TreeNode *root);
     TreeNode *getRoot() { return root; };
-    std::vector<TreeNode *> getNodes() { return nodes; };
+    const std::vector<TreeNode *> &getNodes() const { return nodes; };
     void packFloorplan(std::vector<Block> &blocks);
     void packRest(TreeNode *node, std::vector<Block> &blocks, int x, int y);
     TreeNode *getNode(int blockID) { return nodes[blockID]; };
+    // copies of a tree share its nodes, so a structure is saved and restored
+    // as parent, left and right block ids per node, -1 for none
+    std::vector<int> getLinks();
+    void getLinks(std::vector<int> &links);
+    void setLinks(const std::vector<int> &links);
+    // Zobrist hash of the links (see evaluationCache.h), recomputed by rehashLinks
+    // and kept current by the perturbation operators through toggleChildLinks
+    unsigned long long getLinkHash() { return linkHash; };
+    // restores the hash saved with a set of links, after setLinks
+    void setLinkHash(unsigned long long hash) { linkHash = hash; };
+    void rehashLinks();
+    void toggleChildLinks(TreeNode *node);
 
 private:
     TreeNode *root;
+    unsigned long long linkHash = 0;
     std::vector<TreeNode *> nodes;
 };
 #endif
\ No newline at end of file
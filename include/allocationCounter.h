@@ -0,0 +1,10 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+// heap allocations made by the calling thread so far. only builds configured with
+// -DFP_COUNT_ALLOCATIONS=ON replace operator new to count them, others always return 0
+unsigned long long threadAllocations();
+// whether threadAllocations() counts, i.e. FP_COUNT_ALLOCATIONS was enabled
+bool countsAllocations();
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+#include "designCache.h"
+
+// runs every row of a manifest (one parseJob line per row, blank lines and
+// '#' comments skipped) on a thread pool. each distinct design is parsed once
+// and shared read-only; every job anneals its own copy of the placement.
+// returns the number of rows that failed
+int runBatch(const std::string &manifestPath, int numThreads);
+#endif
@@ -0,0 +1,53 @@
+#ifndef DESIGNCACHE_H
+#define DESIGNCACHE_H
+#include "floorplanner.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// one floorplanning request: design files, cost weight, seed and time budget
+struct FloorplanJob
+{
+    std::string blockPath;
+    std::string netPath;
+    double alpha = 0.5;
+    unsigned int seed = 0;
+    double timeBudget = 0; // seconds, 0 runs the full iteration count
+    std::string outputPath = "output.rpt";
+    ScheduleKind schedule = FAST_SA_SCHEDULE;
+    NetModel netModel;
+    bool stayInOutline = false;
+};
+
+// parses "<block file> <net file> <alpha> <seed> <budget> <output> [fastsa|lam]
+// [net model options] [stay-in-outline]", where the options are formatNetModel's tokens
+bool parseJob(const std::string &line, FloorplanJob &job);
+// "supply-weight=<w> fanout-degree=<pins> fanout-weight=<w> fanout-model=chipbox|exact",
+// the single-run options of the same names as job line tokens
+std::string formatNetModel(const NetModel &model);
+
+// parsed designs keyed by a hash of the block and net file contents and the
+// net model, so an edited file is parsed again while unchanged ones are shared
+// between jobs. the normalization is sampled as every run samples it, see
+// NORMALIZATION_SEED, so cached and uncached runs of a seed anneal alike
+class DesignCache
+{
+public:
+    std::shared_ptr<const Design> get(const std::string &blockPath, const std::string &netPath, std::string &error,
+                                      const NetModel &model = NetModel());
+    int getHits() { return _hits; }
+    int getMisses() { return _misses; }
+
+private:
+    std::mutex _mutex;
+    std::map<uint64_t, std::shared_ptr<const Design>> _designs;
+    int _hits = 0;
+    int _misses = 0;
+};
+
+// runs a job against a cached design and writes its report to job.outputPath
+bool runJob(DesignCache &cache, const FloorplanJob &job, FloorplanResult &result, std::string &error);
+// runs a job on its own copy of an already parsed design
+void runJob(const Design &design, const FloorplanJob &job, FloorplanResult &result);
+#endif
@@ -0,0 +1,48 @@
+#ifndef EVALUATIONCACHE_H
+#define EVALUATIONCACHE_H
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#define EVAL_CACHE_ENTRIES (1 << 14) // slots of an EvaluationCache, direct-mapped by state hash
+
+// Zobrist keys of annealing states. a state hashes to the XOR of the keys of its
+// parent-child links and of the blocks rotated since the run started, so a
+// perturbation updates the hash by toggling the keys of what it changed
+unsigned long long zobristLinkKey(int parent, int child, bool left);
+unsigned long long zobristRotationKey(int block);
+
+// what evaluating a state produced. an evaluation that stopped early once the
+// move was ruled out leaves cost as a lower bound and complete false
+struct CachedEvaluation
+{
+    double cost = 0;
+    double area = 0;
+    double wirelength = 0;
+    bool complete = false;
+    int valid = -1; // 1 legal, 0 overlapping or outside the outline, -1 not checked
+};
+
+// bounded map from state hashes to evaluations. a newer state overwrites the
+// slot it maps to; slots are read and written without locks and a torn read
+// fails the key check, so threads of one chain can share a cache
+class EvaluationCache
+{
+public:
+    EvaluationCache(int entries = EVAL_CACHE_ENTRIES); // rounded up to a power of two
+    bool find(unsigned long long hash, CachedEvaluation &evaluation) const;
+    void store(unsigned long long hash, const CachedEvaluation &evaluation);
+
+private:
+    // check holds the hash XORed with the other words, flags is 0 for an empty slot
+    struct Slot
+    {
+        std::atomic<unsigned long long> check;
+        std::atomic<unsigned long long> cost;
+        std::atomic<unsigned long long> area;
+        std::atomic<unsigned long long> wirelength;
+        std::atomic<unsigned long long> flags;
+    };
+    std::unique_ptr<Slot[]> _slots;
+    size_t _mask;
+};
+#endif
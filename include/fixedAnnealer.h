@@ -0,0 +1,15 @@
+#ifndef FIXEDANNEALER_H
+#define FIXEDANNEALER_H
+#include "floorplanner.h"
+#include "simulatedAnnealing.h"
+#ifndef FIXED_SA_MAX_BLOCKS
+#define FIXED_SA_MAX_BLOCKS 64 // largest design run on the fixed-size engine, 0 disables it
+#endif
+
+// runs the Fast-SA loop on a FixedAnnealer specialized for the design size
+// and cost weighting. the engine follows runFastSA move for move, so a given
+// seed yields the same floorplan; returns false when the design is too large
+// and the generic runFastSA has to be used. with Floorplanner::setSpeculativeThreads
+// it runs a speculative chain instead, see FixedAnnealer::runSpeculative
+bool runFixedSizeSA(Floorplanner *fp, SimulatedAnnealing &sa);
+#endif
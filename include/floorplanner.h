@@ -1,45 +1,216 @@
 #include "module.h"
 #include "BStarTree.h"
+#include <chrono>
+#include <memory>
+#include <random>
 #ifndef FLOORPLANNER_H
 #define FLOORPLANNER_H
+#define NORMALIZATION_SEED 1 // seed of the perturbations sampled for the normalization, the same in every run
 
+class ParetoArchive;
+class SimulatedAnnealing;
+class TemperatureSchedule;
 
+// normalization constants gathered by calcPerturbations. deltas holds the
+// normalized (area, wirelength) change of every sampled perturbation so the
+// average uphill cost can be recomputed for any alpha without re-sampling
+struct NormalizationStats
+{
+    double Anorm = 0;
+    double Wnorm = 0;
+    std::vector<std::pair<double, double>> deltas;
+    double averageUphillCost(double alpha) const;
+};
+
+// a parsed design plus its normalization, shared read-only between jobs
+struct Design
+{
+    PlacementManager manager;
+    int outlineWidth = 0;
+    int outlineHeight = 0;
+    NormalizationStats normalization;
+};
+
+// how nets enter the wirelength cost, applied by Floorplanner::preprocessNets
+struct NetModel
+{
+    double supplyWeight = 1.0;         // nets with a GND/VDD/VSS/VCC pin, 0 drops them
+    int highFanoutDegree = 0;          // nets with at least this many pins, 0 disables
+    double highFanoutWeight = 1.0;     // weight of high-fanout nets, 0 drops them
+    bool approximateHighFanout = true; // evaluate high-fanout nets against the chip box
+
+    // the early exits of calcCost assume the wirelength sum only grows, so weights
+    // cannot be negative; a degree of 1 would mark every net as high-fanout
+    bool isValid() const { return supplyWeight >= 0 && highFanoutWeight >= 0 && (highFanoutDegree == 0 || highFanoutDegree >= 2); }
+};
+
+// temperature schedule of the anneal, see TemperatureSchedule
+enum ScheduleKind
+{
+    FAST_SA_SCHEDULE, // fixed Fast-SA curve from FAST_SA_C, FAST_SA_K and FAST_SA_P
+    LAM_SCHEDULE      // adaptive, follows a target acceptance rate and reheats on stagnation
+};
+
+struct FloorplanResult
+{
+    double cost = 0;
+    double area = 0;
+    double wirelength = 0;
+    double runtime = 0;
+    bool valid = false;
+    int iterations = 0;
+    double firstValidTime = -1; // seconds until the first legal floorplan was evaluated
+    double startCost = 0;       // cost of the floorplan the anneal started from
+    long long allocations = -1; // heap allocations inside the annealing loop, -1 unless built with FP_COUNT_ALLOCATIONS
+    long long cacheLookups = 0; // perturbed states looked up in the evaluation cache
+    long long cacheHits = 0;    // lookups whose cached evaluation replaced packing and costing the state
+};
 
 class Floorplanner
 {
 public:
-    Floorplanner(double alpha, std::ifstream& input_blk, std::ifstream& input_net) : _alpha(alpha), _input_blk(input_blk), _input_net(input_net) { }
+    Floorplanner(double alpha, std::istream& input_blk, std::istream& input_net) : _alpha(alpha), _input_blk(&input_blk), _input_net(&input_net) { }
+    Floorplanner(double alpha, const Design& design);
     PlacementManager manager;
     void floorplan();
-    
-    bool readBlockFile(std::ifstream &input_blk);
-    bool readNetFile(std::ifstream &input_net);
+    bool loadDesign();
+    void prepare();
+    void anneal();
+
+    bool readBlockFile(std::istream &input_blk);
+    bool readNetFile(std::istream &input_net);
+    void preprocessNets();
+    void setNetModel(const NetModel& model) { _netModel = model; };
     int outlineHeight;
     int outlineWidth;
     void checkPlacementInformation() { manager.printInformation(); };
     void calcPerturbations();
     double calcCost();
+    double calcCost(double limit);
+    double getLastArea() { return _lastArea; };
+    double getLastWirelength() { return _lastWirelength; };
     double calcPenaltyCost();
     double calcOutlinePenalty();
     double calcOverlapPenalty();
-    void rotateOperation(BStarTree& tree, std::vector<Block>& blocks);
-    void moveOperation(BStarTree& tree, std::vector<Block>& blocks);
-    void swapOperation(BStarTree& tree, std::vector<Block>& blocks);
+    // perturbations leave packing to the caller and return false when nothing changed
+    bool rotateOperation(std::vector<Block>& blocks);
+    bool moveOperation(BStarTree& tree, std::vector<Block>& blocks);
+    bool swapOperation(BStarTree& tree, std::vector<Block>& blocks);
     int recordOutput(std::vector<Block>& blocks, const std::vector<Net>& nets, const std::vector<Terminal>& terminals, double bestCost, double runtime, std::string output);
     void calculateChipDimensions(std::vector<Block>& blocks, int* maxX, int* maxY);
     BStarTree* getTree() {return &tree;};
     double getAverageUphillCost() { return averageUphillCost; };
+    double getAlpha() { return _alpha; };
+    double getAnorm() { return Anorm; };
+    double getWnorm() { return Wnorm; };
+    const NormalizationStats& getNormalization() const { return _normalization; };
+    void setNormalization(const NormalizationStats& stats);
+
+    // run configuration
+    void setSeed(unsigned int seed) { _rng.seed(seed); };
+    int randInt(int n) { return _rng() % n; };
+    double randUnit() { return _rng() / (double)_rng.max(); };
+    void setTimeBudget(double seconds) { _timeBudget = seconds; };
+    // runs iterations [first, first + count) of the schedule, so a run can be continued in slices
+    void setIterationWindow(int first, int count) { _firstIteration = first; _iterationCount = count; };
+    int getFirstIteration() { return _firstIteration; };
+    int getIterationCount() { return _iterationCount; };
+    // windows of one chain: the schedule and the time spent are kept between anneal()
+    // calls, and each window starts from the state the last one ended in rather than its best
+    void setContinuousChain(bool continuous);
+    bool continuesChain() { return _continuousChain; };
+    // the next window starts from the tree and blocks as they are now, e.g. an adopted migrant
+    void restartChain() { _chainSaved = false; };
+    // engines call this with the current state in the tree and blocks before restoring the best
+    void saveChainState(double runtime);
+    // the schedule of this anneal, kept from the last window when continuing a chain
+    std::shared_ptr<TemperatureSchedule> startSchedule(SimulatedAnnealing& sa);
+    // start of this anneal, moved back by the time earlier windows of the chain took
+    std::chrono::steady_clock::time_point startTime();
+    double getTimeBudget() { return _timeBudget; };
+    void setVerbose(bool verbose) { _verbose = verbose; };
+    bool isVerbose() { return _verbose; };
+    void setOutputPath(const std::string& path) { _outputPath = path; };
+    const std::string& getOutputPath() { return _outputPath; };
+    void setSnapshotPath(const std::string& path) { _snapshotPath = path; };
+    const std::string& getSnapshotPath() { return _snapshotPath; };
+    void recordResult(double cost, double runtime, bool valid);
+    FloorplanResult& getResult() { return _result; };
+    void setConstructiveStart(bool constructive) { _constructiveStart = constructive; };
+    // false forces the generic engine even where a FixedAnnealer would fit
+    void setFixedEngine(bool fixedEngine) { _fixedEngine = fixedEngine; };
+    // cache evaluations of revisited states by their Zobrist hash, see EvaluationCache
+    void setEvaluationCache(bool enabled) { _evaluationCache = enabled; };
+    bool usesEvaluationCache() { return _evaluationCache; };
+    // once the chain holds a legal floorplan, reject moves that leave the outline; off by default
+    void setStayInOutline(bool stay) { _stayInOutline = stay; };
+    bool staysInOutline() { return _stayInOutline; };
+    // Zobrist hash of the blocks rotated by rotateOperation since it was last reset
+    unsigned long long getRotationHash() { return _rotationHash; };
+    void setRotationHash(unsigned long long hash) { _rotationHash = hash; };
+    // threads of one speculative annealing chain, capped at the hardware threads; 0 runs
+    // the sequential chain. only FixedAnnealer speculates, larger designs and Pareto runs stay sequential.
+    // the result of a seed depends on whether the chain speculates but not on the thread count
+    void setSpeculativeThreads(int threads) { _speculativeThreads = threads; };
+    int getSpeculativeThreads() { return _speculativeThreads; };
+    void setRefineThreads(int threads) { _refineThreads = threads; };
+    int getRefineThreads() { return _refineThreads; };
+    // Refiner moves applied to the last result. they act on block positions, so once
+    // any were applied the tree no longer describes manager._blocks
+    int getRefinedMoves() { return _refinedMoves; };
+    void setRefinedMoves(int moves) { _refinedMoves = moves; };
+    bool treeDescribesBlocks() { return _refinedMoves == 0; };
+    void setSchedule(ScheduleKind schedule) { _schedule = schedule; };
+    ScheduleKind getSchedule() { return _schedule; };
+    void setParetoArchive(ParetoArchive* archive) { _archive = archive; };
+    ParetoArchive* getParetoArchive() { return _archive; };
+    // plain HPWL over every net, ignoring the net model, as in the reports
+    double calcExactW(std::vector<Net>& nets);
 private:
     BStarTree tree;
     double _alpha;
-    std::ifstream& _input_blk;
-    std::ifstream& _input_net;
+    std::istream* _input_blk = nullptr;
+    std::istream* _input_net = nullptr;
     double calcW(std::vector<Net>& nets);
+    double calcNetW(Net& net);
     double calcA(std::vector<Block>& blocks);
+    void buildInitialTree();
     double Wnorm;
     double Anorm;
     double averageUphillCost = 0;
     bool isDescendant(TreeNode* target, TreeNode* dest);
+
+    NormalizationStats _normalization;
+    bool _normalized = false;
+    std::mt19937 _rng;
+    double _timeBudget = 0; // seconds, 0 runs the full iteration count
+    int _firstIteration = 0;
+    int _iterationCount = 0; // 0 runs to the end of the schedule
+    bool _continuousChain = false;
+    bool _chainSaved = false;
+    std::vector<int> _chainLinks;
+    std::vector<BlockGeometry> _chainGeometry;
+    double _chainTime = 0;
+    std::shared_ptr<TemperatureSchedule> _chainSchedule;
+    bool _verbose = true;
+    std::string _outputPath = "output.rpt";
+    std::string _snapshotPath; // empty disables the snapshot stream
+    FloorplanResult _result;
+    ParetoArchive* _archive = nullptr;
+    ScheduleKind _schedule = FAST_SA_SCHEDULE;
+    bool _evaluationCache = true;   // skip packing and costing states already in the EvaluationCache
+    unsigned long long _rotationHash = 0;
+    int _speculativeThreads = 0;    // moves evaluated at once by a speculative chain, 0 disables it
+    bool _fixedEngine = true;       // FixedAnnealer for designs of up to FIXED_SA_MAX_BLOCKS blocks
+    int _refineThreads = 0;         // threads of the post-anneal Refiner, 0 skips it
+    int _refinedMoves = 0;
+    bool _constructiveStart = true; // shelf-packed cluster start instead of a complete tree in file order
+    bool _stayInOutline = false;    // confine the chain to legal floorplans after the first one
+    double _lastArea = 0;
+    double _lastWirelength = 0;
+    NetModel _netModel;
+    double _chipWidth = 0;
+    double _chipHeight = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,18 @@
+#ifndef INITIALFLOORPLAN_H
+#define INITIALFLOORPLAN_H
+#include "module.h"
+
+// cluster-growth order: starts from the block with the most weighted
+// connections and repeatedly takes the unplaced block most connected to the
+// placed ones, breaking ties by larger area. nets are weighted 1 / (blocks - 1)
+// and chip-box or dropped nets are ignored, since they do not tell blocks apart
+std::vector<int> clusterOrder(PlacementManager &manager);
+
+// blocks by decreasing height once lying flat, the classic shelf-packing order
+std::vector<int> heightOrder(std::vector<Block> &blocks);
+
+// fills rows no wider than width with blocks in order, rotating each block to
+// suit its row, and moves the tallest block of every row to the front so the
+// rows stack without overlap under BStarTree::packFloorplan. returns the height
+int planShelves(std::vector<Block> &blocks, const std::vector<int> &order, int width, std::vector<std::vector<int>> &rows);
+#endif
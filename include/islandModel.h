@@ -0,0 +1,28 @@
+#ifndef ISLANDMODEL_H
+#define ISLANDMODEL_H
+#include "designCache.h"
+#define ISLAND_EPOCHS 10             // migrations per run, each after an equal slice of the schedule
+#define ISLAND_ACCEPT_TIMEOUT 30     // seconds the coordinator waits for each island to connect
+#define ISLAND_CONNECT_ATTEMPTS 50   // a worker retries its connection every 100 ms this many times
+#define ISLAND_EPOCH_TIMEOUT 600     // seconds an island may take per epoch when the job has no time budget
+#define ISLAND_RECEIVE_GRACE 10      // seconds past the time budget before a silent island is dropped
+
+// island model over Unix or TCP sockets (see socketIO.h for addresses). the
+// coordinator listens on address, optionally starts localWorkers copies of
+// `executable --island-worker address`, and waits for `islands` workers in
+// total. every worker anneals the job's design with seed job.seed + its index
+// as one continuous chain and, after each of `epochs` slices of the schedule,
+// sends the best tree it has found as "STATE <cost> <valid> <bytes>\n" plus an
+// encodeTree payload. the coordinator answers every island with the best state
+// of the epoch as "MIGRANT <cost> <valid> <bytes>\n" plus payload, which an
+// island's chain moves to when it beats the island's best, and ends the run
+// with "DONE\n". an island that does not report within the job's time budget
+// (ISLAND_EPOCH_TIMEOUT without one) plus ISLAND_RECEIVE_GRACE is dropped.
+// the global best is written to job.outputPath. designs are normalized
+// through a DesignCache, so costs are comparable across islands; remote
+// workers need the design files under the same paths, which may not contain
+// whitespace
+int runIslands(const std::string &address, int islands, int localWorkers, const std::string &executable,
+               const FloorplanJob &job, int epochs, int refineThreads);
+int runIslandWorker(const std::string &address);
+#endif
@@ -0,0 +1,27 @@
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+#include "designCache.h"
+#include "threadPool.h"
+
+#define JOB_SERVER_READ_TIMEOUT 5 // seconds a client has to send its request line before it is dropped
+
+// long-lived floorplanning service on a Unix domain or TCP socket. each connection
+// sends one line, either a job in parseJob format or "shutdown", and receives
+// "OK <cost> <area> <wirelength> <runtime> <valid>" or "ERR <message>". requests are
+// read on the accept thread, so a silent client only holds it for JOB_SERVER_READ_TIMEOUT
+class JobServer
+{
+public:
+    JobServer(const std::string &socketPath, int numWorkers) : _socketPath(socketPath), _numWorkers(numWorkers) {}
+    int run();
+
+private:
+    void handleJob(int clientFd, const std::string &request);
+    std::string _socketPath;
+    int _numWorkers;
+    DesignCache _cache;
+};
+
+// sends one request line to a JobServer and stores its reply line
+bool submitRequest(const std::string &socketPath, const std::string &request, std::string &response);
+#endif
@@ -19,11 +19,11 @@ public:
     ~Terminal() {}
 
     // basic access methods
-    const std::string getName() { return _name; }
-    const size_t getX1() { return _x1; }
-    const size_t getX2() { return _x2; }
-    const size_t getY1() { return _y1; }
-    const size_t getY2() { return _y2; }
+    const std::string getName() const { return _name; }
+    const size_t getX1() const { return _x1; }
+    const size_t getX2() const { return _x2; }
+    const size_t getY1() const { return _y1; }
+    const size_t getY2() const { return _y2; }
 
     // set functions
     void setName(std::string &name) { _name = name; }
@@ -70,6 +70,31 @@ private:
     static size_t _maxY; // maximum y coordinate for all blocks
 };
 
+// position and dimensions of a block, saved and restored without copying its name
+struct BlockGeometry
+{
+    size_t x1, y1, x2, y2;
+    size_t w, h;
+};
+
+// copies every block's geometry into geometry, reusing its storage
+inline void saveGeometry(std::vector<Block> &blocks, std::vector<BlockGeometry> &geometry)
+{
+    geometry.resize(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++)
+        geometry[i] = {blocks[i].getX1(), blocks[i].getY1(), blocks[i].getX2(), blocks[i].getY2(), blocks[i].getWidth(), blocks[i].getHeight()};
+}
+
+inline void restoreGeometry(std::vector<Block> &blocks, const std::vector<BlockGeometry> &geometry)
+{
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        blocks[i].setPos(geometry[i].x1, geometry[i].y1, geometry[i].x2, geometry[i].y2);
+        blocks[i].setWidth(geometry[i].w);
+        blocks[i].setHeight(geometry[i].h);
+    }
+}
+
 class Net
 {
 public:
@@ -78,23 +103,64 @@ public:
     ~Net() {}
 
     // basic access methods
-    const std::vector<Terminal *> getTermList() { return _termList; }
+    const std::vector<Terminal *> &getTermList() const { return _termList; }
+    double getWeight() const { return _weight; }
+    bool usesChipBox() const { return _chipBox; }
 
     // modify methods
     void addTerm(Terminal *term) { _termList.push_back(term); }
+    void setWeight(double weight) { _weight = weight; }
+    void setChipBox(double minX, double minY, double maxX, double maxY)
+    {
+        _chipBox = true;
+        _fixedMinX = minX;
+        _fixedMinY = minY;
+        _fixedMaxX = maxX;
+        _fixedMaxY = maxY;
+    }
+    void copyModel(const Net &other)
+    {
+        _weight = other._weight;
+        _chipBox = other._chipBox;
+        _fixedMinX = other._fixedMinX;
+        _fixedMinY = other._fixedMinY;
+        _fixedMaxX = other._fixedMaxX;
+        _fixedMaxY = other._fixedMaxY;
+    }
 
     // other member functions
 
     double calcHPWL();
+    // HPWL with every block pin replaced by the chip's bounding box; exact for
+    // nets that touch every block, an upper bound otherwise
+    double calcChipBoxHPWL(double chipWidth, double chipHeight)
+    {
+        double minX = _fixedMinX < 0 ? _fixedMinX : 0;
+        double minY = _fixedMinY < 0 ? _fixedMinY : 0;
+        double maxX = _fixedMaxX > chipWidth ? _fixedMaxX : chipWidth;
+        double maxY = _fixedMaxY > chipHeight ? _fixedMaxY : chipHeight;
+        return ((maxX - minX)) + ((maxY) - (minY));
+    }
 
 private:
     std::vector<Terminal *> _termList; // list of terminals the net is connected to
+    double _weight = 1.0;              // scale of this net in the wirelength cost, 0 drops it
+    bool _chipBox = false;             // evaluated with calcChipBoxHPWL
+    double _fixedMinX = INT_MAX;       // bounding box of the net's fixed terminals
+    double _fixedMinY = INT_MAX;
+    double _fixedMaxX = 0.0;
+    double _fixedMaxY = 0.0;
 };
 
 
 class PlacementManager
 {
 public:
+    PlacementManager() {}
+    // copies rebind every net to the copied blocks and terminals
+    PlacementManager(const PlacementManager &other) { *this = other; }
+    PlacementManager &operator=(const PlacementManager &other);
+
     std::vector<Block> _blocks;
     std::vector<Terminal> _terminals;
     std::vector<Net> _nets;
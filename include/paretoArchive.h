@@ -0,0 +1,32 @@
+#ifndef PARETOARCHIVE_H
+#define PARETOARCHIVE_H
+#include "module.h"
+
+struct ParetoEntry
+{
+    double area;
+    double wirelength;
+    std::vector<Block> blocks;
+};
+
+// non-dominated set of valid floorplans over (area, wirelength), kept sorted by area;
+// wirelength is the plain HPWL of Floorplanner::calcExactW, as in the reports
+class ParetoArchive
+{
+public:
+    bool dominated(double area, double wirelength) const;
+    bool insert(double area, double wirelength, const std::vector<Block> &blocks);
+    void merge(const ParetoArchive &other);
+    const std::vector<ParetoEntry> &getEntries() const { return _entries; }
+    bool writeFront(const std::string &output) const;
+
+private:
+    std::vector<ParetoEntry> _entries;
+};
+
+// anneals one design with `replicas` runs whose alpha is spread evenly over
+// (0, 1), collecting every valid floorplan into a single Pareto front. replica
+// i is seeded with seed + i
+int runPareto(const std::string &blockPath, const std::string &netPath, const std::string &output, int replicas, double timeBudget,
+              int numThreads, unsigned int seed = 1);
+#endif
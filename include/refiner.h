@@ -0,0 +1,64 @@
+#ifndef REFINER_H
+#define REFINER_H
+#include "floorplanner.h"
+#define REFINE_NEIGHBORS 6      // nearest blocks, by center distance, each block may swap with
+#define REFINE_MAX_MOVES 10000  // cap on applied moves, the descent normally stops far earlier
+
+// block positions and dimensions of a floorplan being refined
+struct RefinePlacement
+{
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<int> width;
+    std::vector<int> height;
+};
+
+// deterministic best-improvement descent from a legal floorplan. each round
+// enumerates every in-place rotation, every slide of a block left or down
+// against its neighbours, and every position swap between nearby blocks,
+// evaluates them split across threads, and applies the single
+// cheapest legal improvement, so the result does not depend on the thread
+// count. moves act on block positions rather than the tree, so a refined
+// floorplan is not the packing of Floorplanner's tree any more, see
+// Floorplanner::treeDescribesBlocks
+class Refiner
+{
+public:
+    Refiner(Floorplanner *fp);
+    // returns the number of applied moves and writes the result back to fp->manager._blocks
+    int run(int numThreads);
+    double getCost() { return _cost; }
+
+private:
+    enum MoveKind
+    {
+        ROTATE,     // a turns 90 degrees about its lower-left corner
+        SWAP,       // a and b trade lower-left corners
+        SLIDE_LEFT, // a moves left until it touches a block or the outline
+        SLIDE_DOWN  // a moves down until it touches a block or the outline
+    };
+    struct Move
+    {
+        MoveKind kind;
+        int a;
+        int b;
+    };
+    std::vector<Move> enumerateMoves();
+    void evaluate(const std::vector<Move> &moves, size_t begin, size_t end, std::vector<double> &costs);
+    bool apply(RefinePlacement &p, const Move &move);
+    bool fits(const RefinePlacement &p, int block, int other);
+    int slideLimit(const RefinePlacement &p, int block, bool left);
+    double calcCost(const RefinePlacement &p);
+
+    Floorplanner *_floorplanner;
+    RefinePlacement _placement;
+    double _cost;
+
+    // net i owns pins [_netStart[i], _netStart[i + 1]), laid out as in FixedAnnealer
+    std::vector<int> _netStart;
+    std::vector<int> _netPins;
+    std::vector<double> _netBox;
+    std::vector<double> _netWeight;
+    std::vector<char> _netChipBox;
+};
+#endif
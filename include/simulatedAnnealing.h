@@ -1,6 +1,7 @@
 #include "module.h"
 #include "floorplanner.h"
 #include "BStarTree.h"
+#include <memory>
 
 #ifndef SIMULATEDANNEALING_H
 #define SIMULATEDANNEALING_H
@@ -9,6 +10,8 @@
 #define FAST_SA_K 7
 #define FAST_SA_P 0.90
 
+class SnapshotWriter;
+
 class SimulatedAnnealing {
     public:
         SimulatedAnnealing(Floorplanner* fp) : _floorplanner(fp) {}
@@ -16,10 +19,14 @@ class SimulatedAnnealing {
         bool checkOutlineValidity();
         bool checkOverlap();
         bool checkTreeValidity(BStarTree& tree);
-        bool acceptSolution(double newCost, double currentCost, double temperature);
+        double acceptanceThreshold(double currentCost, double temperature);
+        double fastSATemperature(int n);
+        std::unique_ptr<SnapshotWriter> openSnapshots();
+        void logProgress(int i, double currentCost, double bestCost, bool currentValid, double temperature, int acceptedMoves, int validSolutions);
+        void finishRun(bool foundValidSolution, double bestCost, double currentCost, double runtime, int acceptedMoves, int validSolutions);
     private:
         Floorplanner* _floorplanner;
         
 
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,35 @@
+#ifndef SNAPSHOTWRITER_H
+#define SNAPSHOTWRITER_H
+#include "module.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#define SNAPSHOT_MAGIC "FPSN"
+#define SNAPSHOT_VERSION 1
+
+// append-only binary log of improving floorplans, little-endian:
+//   header: "FPSN", u32 version, u32 outline width, u32 outline height,
+//           u32 block count, then per block u32 name length + name bytes
+//   record: u64 iteration, f64 seconds, f64 cost, f64 area, f64 wirelength,
+//           then per block u32 x1, y1, x2, y2
+// records are encoded on the caller's thread and written by a background
+// thread, so the anneal only ever waits on a short queue lock
+class SnapshotWriter
+{
+public:
+    SnapshotWriter(const std::string &path, int outlineWidth, int outlineHeight, std::vector<Block> &blocks);
+    ~SnapshotWriter();
+    bool isOpen() { return _file.is_open(); }
+    void record(uint64_t iteration, double seconds, double cost, double area, double wirelength, std::vector<Block> &blocks);
+
+private:
+    void writerLoop();
+    std::ofstream _file;
+    std::thread _writer;
+    std::mutex _mutex;
+    std::condition_variable _pendingReady;
+    std::vector<std::string> _pending;
+    bool _closing = false;
+};
+#endif
@@ -0,0 +1,24 @@
+#ifndef SOCKETIO_H
+#define SOCKETIO_H
+#include <chrono>
+#include <string>
+
+// addresses are "host:port" for TCP and a filesystem path for a Unix domain socket
+
+// listening socket on address, or -1 with error set
+int listenOn(const std::string &address, std::string &error);
+// connected socket to address, or -1
+int connectTo(const std::string &address);
+// removes a Unix socket file left by listenOn, TCP addresses are ignored.
+// listenOn replaces a stale socket file but refuses any other file at the path
+void releaseAddress(const std::string &address);
+
+// the reads wait at most until deadline and fail once it passes; the default waits forever
+typedef std::chrono::steady_clock::time_point Deadline;
+
+// reads up to a newline, which is dropped; false once the peer closes with nothing read
+bool readLine(int fd, std::string &line, Deadline deadline = Deadline::max());
+// reads exactly size bytes
+bool readBytes(int fd, size_t size, std::string &data, Deadline deadline = Deadline::max());
+bool writeAll(int fd, const std::string &data);
+#endif
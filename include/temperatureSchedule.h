@@ -0,0 +1,71 @@
+#ifndef TEMPERATURESCHEDULE_H
+#define TEMPERATURESCHEDULE_H
+#include "floorplanner.h"
+#include "simulatedAnnealing.h"
+#include <algorithm>
+#define LAM_WINDOW 1000        // moves averaged by the acceptance-rate estimate
+#define LAM_STEP 0.999         // temperature factor applied per move towards the target rate
+#define LAM_TARGET_PERIOD 256  // moves between recomputations of the target rate
+#define LAM_STAGNATION 20000   // moves without a new lowest cost before reheating
+#define LAM_REHEAT 4.0         // temperature factor of a reheat, capped at the initial temperature
+#define LAM_FREEZE 0.9         // progress after which the run is left to freeze without reheats
+
+// temperature for each move of an anneal. FAST_SA_SCHEDULE is the fixed
+// Fast-SA curve; LAM_SCHEDULE steers the temperature so a windowed
+// acceptance-rate estimate follows Lam's target curve (from 1.0 down to 0.44,
+// flat, then down to 0) over the run, and reheats when the cost stagnates
+class TemperatureSchedule
+{
+public:
+    TemperatureSchedule(SimulatedAnnealing &sa, ScheduleKind kind, int maxIterations);
+    double temperature(int n)
+    {
+        if (_kind == FAST_SA_SCHEDULE)
+            return _sa.fastSATemperature(n);
+        _iteration = n;
+        return _temperature;
+    }
+    // feeds back the outcome of the move evaluated at temperature(n)
+    void record(bool accepted, double currentCost)
+    {
+        if (_kind == FAST_SA_SCHEDULE)
+            return;
+        _acceptanceRate += ((accepted ? 1.0 : 0.0) - _acceptanceRate) / LAM_WINDOW;
+        if (_iteration % LAM_TARGET_PERIOD == 0)
+            updateTarget();
+        _temperature *= _acceptanceRate > _targetRate ? LAM_STEP : 1.0 / LAM_STEP;
+        _temperature = std::max(_temperature, _finalTemperature);
+        if (currentCost < _lowestCost)
+        {
+            _lowestCost = currentCost;
+            _lastImprovement = _iteration;
+        }
+        else if (_iteration - _lastImprovement >= LAM_STAGNATION && progress() < LAM_FREEZE)
+        {
+            reheat();
+        }
+    }
+    // fraction of a time budget already spent, used instead of the iteration count when larger
+    void setProgress(double progress) { _timeProgress = progress; }
+    int getReheats() { return _reheats; }
+
+private:
+    double progress() { return std::max(_timeProgress, (double)_iteration / _maxIterations); }
+    void updateTarget();
+    void reheat();
+
+    SimulatedAnnealing _sa; // a copy, so a schedule kept by a continuous chain outlives its run
+    ScheduleKind _kind;
+    int _maxIterations;
+    int _iteration = 0;
+    double _timeProgress = 0;
+    double _initialTemperature;
+    double _temperature;
+    double _finalTemperature;
+    double _acceptanceRate = 1.0;
+    double _targetRate = 1.0;
+    double _lowestCost;
+    int _lastImprovement = 0;
+    int _reheats = 0;
+};
+#endif
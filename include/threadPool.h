@@ -0,0 +1,30 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads draining a FIFO task queue
+class ThreadPool
+{
+public:
+    ThreadPool(int numThreads);
+    ~ThreadPool();
+    void submit(std::function<void()> task);
+    void wait(); // blocks until every submitted task has finished
+    int size() { return _workers.size(); }
+
+private:
+    void workerLoop();
+    std::vector<std::thread> _workers;
+    std::queue<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _taskReady;
+    std::condition_variable _idle;
+    int _running = 0;
+    bool _stopping = false;
+};
+#endif
@@ -0,0 +1,15 @@
+#ifndef TREECODEC_H
+#define TREECODEC_H
+#include "BStarTree.h"
+
+// compact B*-tree state for migration between processes, little-endian:
+//   u16 block count, then a bit stream walking the tree in preorder from the
+//   root with, per node, its block id in ceil(log2(count)) bits and one bit
+//   each for "has left child", "has right child" and "stands upright"
+// a block stands upright when it is taller than wide, so orientations need
+// no reference to the block file. ami33 encodes in 40 bytes
+std::string encodeTree(BStarTree &tree, std::vector<Block> &blocks);
+// rebuilds the links and block orientations of a tree with the same blocks;
+// returns false on malformed data. the caller repacks the blocks
+bool decodeTree(const std::string &data, BStarTree &tree, std::vector<Block> &blocks);
+#endif
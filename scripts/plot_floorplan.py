@@ -3,8 +3,10 @@ import matplotlib.pyplot as plt
 import matplotlib.patches as patches
 import sys
 import random
+import struct
 
 #USAGE: python3 plot_floorplan.py output.rpt
+#       python3 plot_floorplan.py --animate snapshots.bin [output.gif]
 def parse_output_file(filename):
     """Parse the output.rpt file and extract macro information."""
     with open(filename, 'r') as f:
@@ -45,6 +47,95 @@ def parse_output_file(filename):
         'macros': macros
     }
 
+def parse_snapshot_file(filename):
+    """Parse the binary snapshot stream written by fp (see snapshotWriter.h)."""
+    with open(filename, 'rb') as f:
+        raw = f.read()
+
+    if raw[:4] != b'FPSN':
+        raise ValueError(f'{filename} is not a snapshot stream')
+    version, outline_width, outline_height, num_blocks = struct.unpack_from('<4I', raw, 4)
+    offset = 20
+    names = []
+    for _ in range(num_blocks):
+        (length,) = struct.unpack_from('<I', raw, offset)
+        offset += 4
+        names.append(raw[offset:offset + length].decode())
+        offset += length
+
+    # a record may be cut short if the run is still writing
+    record_size = 40 + 16 * num_blocks
+    snapshots = []
+    while offset + record_size <= len(raw):
+        iteration, seconds, cost, area, wirelength = struct.unpack_from('<Q4d', raw, offset)
+        coords = struct.unpack_from(f'<{4 * num_blocks}I', raw, offset + 40)
+        offset += record_size
+        macros = []
+        for i, name in enumerate(names):
+            x1, y1, x2, y2 = coords[4 * i:4 * i + 4]
+            macros.append({
+                'name': name,
+                'x1': x1, 'y1': y1, 'x2': x2, 'y2': y2,
+                'width': x2 - x1,
+                'height': y2 - y1
+            })
+        snapshots.append({
+            'iteration': iteration,
+            'seconds': seconds,
+            'cost': cost,
+            'area': area,
+            'wirelength': wirelength,
+            'macros': macros
+        })
+
+    return {
+        'version': version,
+        'outline_width': outline_width,
+        'outline_height': outline_height,
+        'snapshots': snapshots
+    }
+
+def animate_snapshots(data, output_filename=None):
+    """Replay the best-solution snapshots to show convergence."""
+    from matplotlib.animation import FuncAnimation
+
+    snapshots = data['snapshots']
+    if not snapshots:
+        print("Snapshot stream contains no solutions.")
+        return
+    fig, ax = plt.subplots(1, 1, figsize=(12, 10))
+    colors = plt.cm.Set3(range(len(snapshots[0]['macros'])))
+
+    def draw(frame):
+        snap = snapshots[frame]
+        ax.clear()
+        ax.set_xlim(0, data['outline_width'])
+        ax.set_ylim(0, data['outline_height'])
+        ax.set_aspect('equal')
+        ax.invert_yaxis()
+        for i, macro in enumerate(snap['macros']):
+            ax.add_patch(patches.Rectangle(
+                (macro['x1'], macro['y1']), macro['width'], macro['height'],
+                linewidth=1, edgecolor='black',
+                facecolor=colors[i % len(colors)], alpha=0.7))
+            ax.text(macro['x1'] + macro['width'] / 2, macro['y1'] + macro['height'] / 2,
+                    macro['name'], ha='center', va='center', fontsize=8, weight='bold')
+        ax.add_patch(patches.Rectangle(
+            (0, 0), data['outline_width'], data['outline_height'],
+            linewidth=3, edgecolor='red', facecolor='none'))
+        ax.grid(True, alpha=0.3)
+        ax.set_title(f'Iteration {snap["iteration"]} ({snap["seconds"]:.3f}s)\n' +
+                     f'Cost: {snap["cost"]:.4f}, Area: {snap["area"]:.0f}, ' +
+                     f'Wirelength: {snap["wirelength"]:.0f}')
+
+    animation = FuncAnimation(fig, draw, frames=len(snapshots), interval=300, repeat=False)
+
+    if output_filename:
+        animation.save(output_filename, dpi=100)
+        print(f"Saved animation to {output_filename}")
+
+    plt.show()
+
 def plot_floorplan(data, output_filename=None):
     """Create a visualization of the floorplan."""
     fig, ax = plt.subplots(1, 1, figsize=(12, 10))
@@ -140,7 +231,21 @@ def check_overlaps(macros):
 def main():
     if len(sys.argv) < 2:
         print("Usage: python plot_floorplan.py <output.rpt> [output_image.png]")
+        print("       python plot_floorplan.py --animate <snapshots.bin> [output.gif]")
         sys.exit(1)
+
+    if sys.argv[1] == '--animate':
+        if len(sys.argv) < 3:
+            print("Usage: python plot_floorplan.py --animate <snapshots.bin> [output.gif]")
+            sys.exit(1)
+        try:
+            data = parse_snapshot_file(sys.argv[2])
+        except Exception as e:
+            print(f"Error reading file: {e}")
+            sys.exit(1)
+        print(f"Read {len(data['snapshots'])} snapshots.")
+        animate_snapshots(data, sys.argv[3] if len(sys.argv) > 3 else None)
+        return
     
     input_file = sys.argv[1]
     output_file = sys.argv[2] if len(sys.argv) > 2 else None
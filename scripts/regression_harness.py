@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+import argparse
+import glob
+import json
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+#USAGE: python3 regression_harness.py --fp build/fp [--baseline baseline.json] [--report report.json]
+#       python3 regression_harness.py --fp build/fp --save-baseline baseline.json
+
+# metric name -> True when larger is better
+METRICS = {
+    'iterations_per_sec': True,
+    'time_to_first_valid': False,
+    'area': False,
+    'hpwl': False,
+    'cost': False,
+}
+# wall-clock metrics are noisy, so they need a larger relative change to count
+TIMING_METRICS = {'iterations_per_sec', 'time_to_first_valid'}
+# on designs this large a chain that stays in the outline has to improve on its
+# constructive start; an unconfined chain may drift out of it and keep the start
+IMPROVEMENT_MIN_BLOCKS = 30
+
+def parse_block_file(filename):
+    """Return the outline, block dimensions and terminal positions of a .block file."""
+    with open(filename, 'r') as f:
+        lines = [line.split() for line in f if line.strip()]
+    outline = (int(lines[0][1]), int(lines[0][2]))
+    num_blocks = int(lines[1][1])
+    num_terminals = int(lines[2][1])
+    blocks = {}
+    for parts in lines[3:3 + num_blocks]:
+        blocks[parts[0]] = (int(parts[1]), int(parts[2]))
+    terminals = {}
+    for parts in lines[3 + num_blocks:3 + num_blocks + num_terminals]:
+        terminals[parts[0]] = (int(parts[2]), int(parts[3]))
+    return outline, blocks, terminals
+
+def parse_net_file(filename):
+    """Return every net as a list of pin names."""
+    with open(filename, 'r') as f:
+        tokens = f.read().split()
+    nets = []
+    i = 2
+    while i < len(tokens):
+        degree = int(tokens[i + 1])
+        nets.append(tokens[i + 2:i + 2 + degree])
+        i += 2 + degree
+    return nets
+
+def parse_report(filename):
+    """Parse an output.rpt file (same layout as plot_floorplan.py reads)."""
+    with open(filename, 'r') as f:
+        lines = f.readlines()
+    macros = {}
+    for line in lines[5:]:
+        parts = line.split()
+        if len(parts) == 5:
+            macros[parts[0]] = tuple(int(p) for p in parts[1:])
+    return {
+        'cost': float(lines[0]),
+        'wirelength': float(lines[1]),
+        'area': float(lines[2]),
+        'macros': macros,
+    }
+
+def validate_report(report, outline, blocks, terminals, nets):
+    """Recompute legality, area and HPWL of a report; return (legal, area, hpwl, errors)."""
+    errors = []
+    macros = report['macros']
+    if set(macros) != set(blocks):
+        errors.append('report does not list every block exactly once')
+    for name, (x1, y1, x2, y2) in macros.items():
+        dims = (x2 - x1, y2 - y1)
+        if name in blocks and dims != blocks[name] and dims != blocks[name][::-1]:
+            errors.append(f'{name} has dimensions {dims}, expected {blocks[name]}')
+
+    legal = True
+    names = list(macros)
+    for i in range(len(names)):
+        a = macros[names[i]]
+        if a[2] > outline[0] or a[3] > outline[1]:
+            legal = False
+        for j in range(i + 1, len(names)):
+            b = macros[names[j]]
+            if a[0] < b[2] and b[0] < a[2] and a[1] < b[3] and b[1] < a[3]:
+                legal = False
+
+    width = max((m[2] for m in macros.values()), default=0)
+    height = max((m[3] for m in macros.values()), default=0)
+    area = width * height
+
+    hpwl = 0
+    for net in nets:
+        xs1, ys1, xs2, ys2 = [], [], [], []
+        for pin in net:
+            if pin in terminals:
+                x, y = terminals[pin]
+                xs1.append(x); ys1.append(y); xs2.append(x); ys2.append(y)
+            elif pin in macros:
+                x1, y1, x2, y2 = macros[pin]
+                xs1.append(x1); ys1.append(y1); xs2.append(x2); ys2.append(y2)
+        if xs1:
+            hpwl += (max(xs2) - min(xs1)) + (max(ys2) - min(ys1))
+
+    if area != report['area']:
+        errors.append(f'reported area {report["area"]} but blocks span {area}')
+    if hpwl != report['wirelength']:
+        errors.append(f'reported wirelength {report["wirelength"]} but recomputed HPWL is {hpwl}')
+    return legal, area, hpwl, errors
+
+def parse_batch_line(line):
+    """Parse one result line printed by fp --batch."""
+    parts = line.split()
+    values = dict(zip(parts[1::2], parts[2::2]))
+    return parts[0], {key: float(value) for key, value in values.items()}
+
+def run_design(fp, block_file, net_file, seeds, alpha, budget, schedule, stay_in_outline, workdir):
+    """Run fp once per seed on one design and validate every report."""
+    name = os.path.splitext(os.path.basename(block_file))[0]
+    outline, blocks, terminals = parse_block_file(block_file)
+    nets = parse_net_file(net_file)
+
+    manifest = os.path.join(workdir, f'{name}.manifest')
+    outputs = {}
+    with open(manifest, 'w') as f:
+        for seed in seeds:
+            output = os.path.join(workdir, f'{name}_{seed}.rpt')
+            outputs[output] = seed
+            options = ' stay-in-outline' if stay_in_outline else ''
+            f.write(f'{block_file} {net_file} {alpha} {seed} {budget} {output} {schedule}{options}\n')
+
+    # one worker keeps the throughput numbers comparable between runs
+    result = subprocess.run([fp, '--batch', manifest, '1'], capture_output=True, text=True)
+    runs = []
+    failures = []
+    for line in result.stdout.splitlines():
+        parts = line.split()
+        if not parts or parts[0] not in outputs:
+            continue
+        output, values = parse_batch_line(line)
+        report = parse_report(output)
+        legal, area, hpwl, errors = validate_report(report, outline, blocks, terminals, nets)
+        claimed_valid = values['valid'] == 1
+        if claimed_valid and not legal:
+            errors.append('fp reported a valid floorplan that overlaps or leaves the outline')
+        if stay_in_outline and len(blocks) >= IMPROVEMENT_MIN_BLOCKS and not (claimed_valid and values['cost'] < values['startcost']):
+            errors.append(f'the anneal did not improve on its start (cost {values["cost"]:g}, '
+                          f'start {values["startcost"]:g})')
+        failures.extend(f'{name} seed {outputs[output]}: {error}' for error in errors)
+        runs.append({
+            'seed': outputs[output],
+            'valid': legal,
+            'iterations_per_sec': values['iterations'] / values['runtime'] if values['runtime'] > 0 else None,
+            'time_to_first_valid': values['firstvalid'] if values['firstvalid'] >= 0 else None,
+            'area': area,
+            'hpwl': hpwl,
+            'cost': report['cost'],
+        })
+    if len(runs) != len(seeds):
+        failures.append(f'{name}: fp produced {len(runs)} of {len(seeds)} results (exit code {result.returncode})')
+    return name, runs, failures
+
+def summarize(runs):
+    """Mean, sample standard deviation and count of every metric."""
+    summary = {'valid_rate': sum(run['valid'] for run in runs) / len(runs) if runs else 0}
+    for metric in METRICS:
+        values = [run[metric] for run in runs if run[metric] is not None]
+        if not values:
+            continue
+        mean = sum(values) / len(values)
+        variance = sum((v - mean) ** 2 for v in values) / (len(values) - 1) if len(values) > 1 else 0
+        summary[metric] = {'mean': mean, 'stdev': math.sqrt(variance), 'n': len(values)}
+    return summary
+
+def compare(current, baseline, threshold, tolerance, timing_tolerance):
+    """Welch's t statistic per metric; a change must clear both the t threshold and the relative tolerance."""
+    comparison = {}
+    regressions = []
+    for design, summary in current.items():
+        if design not in baseline:
+            continue
+        for metric, larger_is_better in METRICS.items():
+            if metric not in summary or metric not in baseline[design]:
+                continue
+            new, old = summary[metric], baseline[design][metric]
+            delta = new['mean'] - old['mean']
+            spread = math.sqrt(new['stdev'] ** 2 / new['n'] + old['stdev'] ** 2 / old['n'])
+            t = delta / spread if spread > 0 else (0.0 if delta == 0 else math.copysign(math.inf, delta))
+            relative = delta / old['mean'] if old['mean'] != 0 else 0.0
+            verdict = 'unchanged'
+            needed = timing_tolerance if metric in TIMING_METRICS else tolerance
+            if abs(t) >= threshold and abs(relative) >= needed:
+                verdict = 'improved' if (delta > 0) == larger_is_better else 'regressed'
+            if verdict == 'regressed':
+                regressions.append(f'{design} {metric}: {old["mean"]:.6g} -> {new["mean"]:.6g}')
+            comparison.setdefault(design, {})[metric] = {
+                'baseline': old['mean'],
+                'current': new['mean'],
+                'relative_change': relative,
+                't': t if math.isfinite(t) else str(t),
+                'verdict': verdict,
+            }
+    return comparison, regressions
+
+def main():
+    parser = argparse.ArgumentParser(description='Quality and throughput regression harness for fp.')
+    parser.add_argument('--fp', required=True, help='path to the fp executable')
+    parser.add_argument('--inputs', default=os.path.join(os.path.dirname(__file__), '..', 'inputs'))
+    parser.add_argument('--seeds', type=int, default=3, help='repetitions per design, seeded 1..N')
+    parser.add_argument('--alpha', type=float, default=0.5)
+    parser.add_argument('--budget', type=float, default=0, help='seconds per run, 0 runs every iteration')
+    parser.add_argument('--schedule', choices=['fastsa', 'lam'], default='fastsa', help='temperature schedule')
+    parser.add_argument('--stay-in-outline', action='store_true',
+                        help='confine each chain to legal floorplans once it has found one')
+    parser.add_argument('--report', default='harness_report.json')
+    parser.add_argument('--baseline', help='summary JSON to compare against')
+    parser.add_argument('--save-baseline', help='write this run\'s summary as a baseline')
+    parser.add_argument('--threshold', type=float, default=3.0, help='|t| needed to call a change')
+    parser.add_argument('--tolerance', type=float, default=0.02, help='relative change needed to call a quality change')
+    parser.add_argument('--timing-tolerance', type=float, default=0.15, help='relative change needed to call a timing change')
+    args = parser.parse_args()
+
+    fp = os.path.abspath(args.fp)
+    seeds = list(range(1, args.seeds + 1))
+    designs = {}
+    failures = []
+    with tempfile.TemporaryDirectory() as workdir:
+        for block_file in sorted(glob.glob(os.path.join(args.inputs, '*.block'))):
+            net_file = os.path.splitext(block_file)[0] + '.nets'
+            if not os.path.exists(net_file):
+                continue
+            name, runs, design_failures = run_design(fp, os.path.abspath(block_file), os.path.abspath(net_file),
+                                                     seeds, args.alpha, args.budget, args.schedule,
+                                                     args.stay_in_outline, workdir)
+            designs[name] = {'runs': runs, 'summary': summarize(runs)}
+            failures.extend(design_failures)
+            print(f'{name}: ' + ', '.join(f'{metric} {value["mean"]:.6g}' for metric, value
+                                         in designs[name]['summary'].items() if isinstance(value, dict)))
+
+    summaries = {name: design['summary'] for name, design in designs.items()}
+    report = {
+        'config': {'seeds': seeds, 'alpha': args.alpha, 'budget': args.budget, 'schedule': args.schedule,
+                   'stay_in_outline': args.stay_in_outline},
+        'designs': designs,
+        'failures': failures,
+    }
+    regressions = []
+    if args.baseline and os.path.exists(args.baseline):
+        with open(args.baseline, 'r') as f:
+            baseline = json.load(f)
+        report['comparison'], regressions = compare(summaries, baseline, args.threshold, args.tolerance,
+                                                      args.timing_tolerance)
+        report['regressions'] = regressions
+    elif args.baseline:
+        print(f'No baseline at {args.baseline}, skipping comparison.')
+
+    with open(args.report, 'w') as f:
+        json.dump(report, f, indent=2)
+    print(f'Report written to {args.report}')
+    if args.save_baseline:
+        with open(args.save_baseline, 'w') as f:
+            json.dump(summaries, f, indent=2)
+        print(f'Baseline written to {args.save_baseline}')
+
+    for failure in failures:
+        print(f'FAILED: {failure}')
+    for regression in regressions:
+        print(f'REGRESSED: {regression}')
+    sys.exit(1 if failures or regressions else 0)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,47 @@
+#include "allocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef FP_COUNT_ALLOCATIONS
+
+static thread_local unsigned long long allocationCount = 0;
+
+unsigned long long threadAllocations() { return allocationCount; }
+bool countsAllocations() { return true; }
+
+// every form of new funnels through here so the count covers containers, strings and streams alike
+static void* countedAllocation(std::size_t size)
+{
+    allocationCount++;
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(std::size_t size) { return countedAllocation(size); }
+void* operator new[](std::size_t size) { return countedAllocation(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    allocationCount++;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    allocationCount++;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+
+#else
+
+unsigned long long threadAllocations() { return 0; }
+bool countsAllocations() { return false; }
+
+#endif
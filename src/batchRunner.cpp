@@ -0,0 +1,80 @@
+#include "batchRunner.h"
+#include "threadPool.h"
+#include <chrono>
+
+int runBatch(const std::string &manifestPath, int numThreads)
+{
+    std::ifstream manifest(manifestPath);
+    if (!manifest)
+    {
+        std::cerr << "Cannot open the manifest \"" << manifestPath << "\"" << std::endl;
+        return 1;
+    }
+
+    std::vector<FloorplanJob> jobs;
+    int failures = 0;
+    std::string line;
+    for (int lineNumber = 1; getline(manifest, line); lineNumber++)
+    {
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+        FloorplanJob job;
+        if (!parseJob(line, job))
+        {
+            std::cerr << manifestPath << ":" << lineNumber << ": malformed row" << std::endl;
+            failures++;
+            continue;
+        }
+        jobs.push_back(job);
+    }
+
+    // resolve designs up front so the workers only ever read them
+    DesignCache cache;
+    std::map<std::string, std::shared_ptr<const Design>> designs;
+    std::vector<const Design *> jobDesigns(jobs.size(), nullptr);
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        std::string key = jobs[i].blockPath + "\n" + jobs[i].netPath + "\n" + formatNetModel(jobs[i].netModel);
+        if (designs.find(key) == designs.end())
+        {
+            std::string error;
+            designs[key] = cache.get(jobs[i].blockPath, jobs[i].netPath, error, jobs[i].netModel);
+            if (!designs[key])
+                std::cerr << error << std::endl;
+        }
+        jobDesigns[i] = designs[key].get();
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<FloorplanResult> results(jobs.size());
+    {
+        ThreadPool pool(numThreads);
+        for (size_t i = 0; i < jobs.size(); i++)
+        {
+            if (jobDesigns[i] == nullptr)
+                continue;
+            pool.submit([&, i] { runJob(*jobDesigns[i], jobs[i], results[i]); });
+        }
+        pool.wait();
+    }
+    double runtime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        if (jobDesigns[i] == nullptr)
+        {
+            std::cout << "FAILED " << jobs[i].outputPath << std::endl;
+            failures++;
+            continue;
+        }
+        std::cout << jobs[i].outputPath << " cost " << results[i].cost << " area " << results[i].area
+                  << " wirelength " << results[i].wirelength << " runtime " << results[i].runtime
+                  << " valid " << results[i].valid << " iterations " << results[i].iterations
+                  << " firstvalid " << results[i].firstValidTime << " cachehits " << results[i].cacheHits
+                  << " cachelookups " << results[i].cacheLookups << " startcost " << results[i].startCost << std::endl;
+    }
+    std::cout << "Batch: " << jobs.size() << " jobs, " << designs.size() << " designs, "
+              << failures << " failed, " << runtime << " seconds" << std::endl;
+    return failures;
+}
@@ -0,0 +1,145 @@
+#include "designCache.h"
+#include <iomanip>
+
+static bool readFile(const std::string &path, std::string &contents)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+        return false;
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+// 64-bit FNV-1a
+static uint64_t hashBytes(const std::string &bytes, uint64_t hash = 14695981039346656037ULL)
+{
+    for (unsigned char c : bytes)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool parseJob(const std::string &line, FloorplanJob &job)
+{
+    std::istringstream stream(line);
+    if (!(stream >> job.blockPath >> job.netPath >> job.alpha >> job.seed >> job.timeBudget >> job.outputPath))
+        return false;
+    job.schedule = FAST_SA_SCHEDULE;
+    job.netModel = NetModel();
+    job.stayInOutline = false;
+    std::string token;
+    while (stream >> token)
+    {
+        size_t equals = token.find('=');
+        std::string name = token.substr(0, equals);
+        std::istringstream value(equals == std::string::npos ? "" : token.substr(equals + 1));
+        bool parsed = true;
+        if (token == "fastsa")
+            job.schedule = FAST_SA_SCHEDULE;
+        else if (token == "lam")
+            job.schedule = LAM_SCHEDULE;
+        else if (token == "stay-in-outline")
+            job.stayInOutline = true;
+        else if (name == "supply-weight")
+            parsed = (bool)(value >> job.netModel.supplyWeight);
+        else if (name == "fanout-degree")
+            parsed = (bool)(value >> job.netModel.highFanoutDegree);
+        else if (name == "fanout-weight")
+            parsed = (bool)(value >> job.netModel.highFanoutWeight);
+        else if (name == "fanout-model" && (value.str() == "exact" || value.str() == "chipbox"))
+            job.netModel.approximateHighFanout = value.str() == "chipbox";
+        else
+            parsed = false;
+        if (!parsed)
+            return false;
+    }
+    return job.netModel.isValid();
+}
+
+std::string formatNetModel(const NetModel &model)
+{
+    std::ostringstream tokens;
+    tokens << std::setprecision(17) << "supply-weight=" << model.supplyWeight << " fanout-degree=" << model.highFanoutDegree
+           << " fanout-weight=" << model.highFanoutWeight << " fanout-model=" << (model.approximateHighFanout ? "chipbox" : "exact");
+    return tokens.str();
+}
+
+std::shared_ptr<const Design> DesignCache::get(const std::string &blockPath, const std::string &netPath, std::string &error,
+                                               const NetModel &model)
+{
+    std::string blockContents;
+    std::string netContents;
+    if (!readFile(blockPath, blockContents))
+    {
+        error = "cannot open " + blockPath;
+        return nullptr;
+    }
+    if (!readFile(netPath, netContents))
+    {
+        error = "cannot open " + netPath;
+        return nullptr;
+    }
+    uint64_t key = hashBytes(formatNetModel(model), hashBytes(netContents, hashBytes(blockContents)));
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _designs.find(key);
+        if (it != _designs.end())
+        {
+            _hits++;
+            return it->second;
+        }
+    }
+
+    // parse and normalize outside the lock; a racing miss on the same key just loses the insert
+    std::istringstream blockStream(blockContents);
+    std::istringstream netStream(netContents);
+    Floorplanner parser(0.5, blockStream, netStream);
+    parser.setVerbose(false);
+    parser.setNetModel(model);
+    if (!parser.loadDesign() || parser.manager._blocks.empty())
+    {
+        error = "cannot parse " + blockPath;
+        return nullptr;
+    }
+    std::shared_ptr<Design> design = std::make_shared<Design>();
+    design->manager = parser.manager;
+    design->outlineWidth = parser.outlineWidth;
+    design->outlineHeight = parser.outlineHeight;
+    parser.prepare();
+    design->normalization = parser.getNormalization();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto inserted = _designs.emplace(key, design);
+    if (inserted.second)
+        _misses++;
+    else
+        _hits++;
+    return inserted.first->second;
+}
+
+bool runJob(DesignCache &cache, const FloorplanJob &job, FloorplanResult &result, std::string &error)
+{
+    std::shared_ptr<const Design> design = cache.get(job.blockPath, job.netPath, error, job.netModel);
+    if (!design)
+        return false;
+    runJob(*design, job, result);
+    return true;
+}
+
+void runJob(const Design &design, const FloorplanJob &job, FloorplanResult &result)
+{
+    Floorplanner fp(job.alpha, design);
+    fp.setVerbose(false);
+    fp.setSeed(job.seed);
+    fp.setTimeBudget(job.timeBudget);
+    fp.setSchedule(job.schedule);
+    fp.setStayInOutline(job.stayInOutline);
+    fp.setOutputPath(job.outputPath);
+    fp.floorplan();
+    result = fp.getResult();
+}
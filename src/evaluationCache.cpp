@@ -0,0 +1,83 @@
+#include "evaluationCache.h"
+#include <cstring>
+
+#define SLOT_PRESENT 1  // flags bit of a filled slot
+#define SLOT_COMPLETE 2 // flags bit of a complete evaluation
+#define SLOT_CHECKED 4  // flags bit set once validity was checked
+#define SLOT_VALID 8    // flags bit of a legal floorplan
+
+// splitmix64 finalizer, spreads consecutive codes over all 64 bits
+static unsigned long long mix(unsigned long long x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// keys are derived on demand rather than tabled, so any design size works without setup
+unsigned long long zobristLinkKey(int parent, int child, bool left)
+{
+    return mix(((unsigned long long)parent << 33) ^ ((unsigned long long)child << 1) ^ (left ? 1 : 0));
+}
+
+unsigned long long zobristRotationKey(int block)
+{
+    return mix(~(unsigned long long)block);
+}
+
+static unsigned long long toBits(double value)
+{
+    unsigned long long bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double fromBits(unsigned long long bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+EvaluationCache::EvaluationCache(int entries)
+{
+    size_t size = 1;
+    while ((int)size < entries)
+        size <<= 1;
+    _slots.reset(new Slot[size]());
+    _mask = size - 1;
+}
+
+bool EvaluationCache::find(unsigned long long hash, CachedEvaluation &evaluation) const
+{
+    const Slot &slot = _slots[hash & _mask];
+    unsigned long long flags = slot.flags.load(std::memory_order_relaxed);
+    unsigned long long cost = slot.cost.load(std::memory_order_relaxed);
+    unsigned long long area = slot.area.load(std::memory_order_relaxed);
+    unsigned long long wirelength = slot.wirelength.load(std::memory_order_relaxed);
+    unsigned long long check = slot.check.load(std::memory_order_relaxed);
+    if (!(flags & SLOT_PRESENT) || (check ^ cost ^ area ^ wirelength ^ flags) != hash)
+        return false;
+    evaluation.cost = fromBits(cost);
+    evaluation.area = fromBits(area);
+    evaluation.wirelength = fromBits(wirelength);
+    evaluation.complete = flags & SLOT_COMPLETE;
+    evaluation.valid = (flags & SLOT_CHECKED) ? (flags & SLOT_VALID ? 1 : 0) : -1;
+    return true;
+}
+
+void EvaluationCache::store(unsigned long long hash, const CachedEvaluation &evaluation)
+{
+    Slot &slot = _slots[hash & _mask];
+    unsigned long long flags = SLOT_PRESENT | (evaluation.complete ? SLOT_COMPLETE : 0) |
+                               (evaluation.valid >= 0 ? SLOT_CHECKED : 0) | (evaluation.valid == 1 ? SLOT_VALID : 0);
+    unsigned long long cost = toBits(evaluation.cost);
+    unsigned long long area = toBits(evaluation.area);
+    unsigned long long wirelength = toBits(evaluation.wirelength);
+    slot.flags.store(flags, std::memory_order_relaxed);
+    slot.cost.store(cost, std::memory_order_relaxed);
+    slot.area.store(area, std::memory_order_relaxed);
+    slot.wirelength.store(wirelength, std::memory_order_relaxed);
+    slot.check.store(hash ^ cost ^ area ^ wirelength ^ flags, std::memory_order_relaxed);
+}
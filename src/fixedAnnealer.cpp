@@ -0,0 +1,984 @@
+#include "fixedAnnealer.h"
+#include "paretoArchive.h"
+#include "snapshotWriter.h"
+#include "temperatureSchedule.h"
+#include "allocationCounter.h"
+#include "evaluationCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#define SPECULATION_SPIN 200 // polls of a speculation signal, each yielding the core, before the waiting thread sleeps
+
+enum CostMode
+{
+    BLENDED_COST,    // alpha * A/Anorm + (1 - alpha) * W/Wnorm
+    AREA_COST,       // alpha == 1, wirelength is never evaluated for the cost
+    WIRELENGTH_COST  // alpha == 0, area is never evaluated for the cost
+};
+
+// block dimensions and packed positions, copied by value to save and restore
+template <int MaxBlocks>
+struct FixedPlacement
+{
+    int width[MaxBlocks];
+    int height[MaxBlocks];
+    int x[MaxBlocks];
+    int y[MaxBlocks];
+    unsigned long long rotationHash; // Zobrist keys of the blocks rotated since the run started
+};
+
+// tree links of a FixedAnnealer, saved before a move so that a rejection can undo it
+template <int MaxBlocks>
+struct FixedLinks
+{
+    int parent[MaxBlocks];
+    int left[MaxBlocks];
+    int right[MaxBlocks];
+    unsigned long long hash;
+};
+
+// random stream of one speculative candidate, keyed by the run seed and the
+// candidate's iteration so that any thread count draws the same moves
+struct CandidateRng
+{
+    unsigned long long state;
+    CandidateRng(unsigned long long seed, int iteration) : state(seed ^ (0xd1b54a32d192ed03ULL * (iteration + 1ULL))) {}
+    unsigned long long next()
+    {
+        unsigned long long x = (state += 0x9e3779b97f4a7c15ULL);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+    int randInt(int n) { return next() % n; }
+    double randUnit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// a counter that speculation threads wait on: polled briefly, since a batch takes
+// about a microsecond, then slept on so idle threads do not hold a core
+struct SpeculationSignal
+{
+    std::atomic<int> value;
+    std::mutex mutex;
+    std::condition_variable changed;
+    SpeculationSignal() : value(0) {}
+    template <class Predicate>
+    void waitUntil(Predicate ready)
+    {
+        for (int spin = 0; spin < SPECULATION_SPIN; spin++)
+        {
+            if (ready())
+                return;
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, ready);
+    }
+    // wakes the sleepers after value or another watched flag changed
+    void notify()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        changed.notify_all();
+    }
+};
+
+// what a speculative candidate produced; evaluation.cost is its cost or, when rejected, a lower bound
+struct CandidateOutcome
+{
+    bool accepted = false;
+    CachedEvaluation evaluation;
+    long long cacheLookups = 0;
+    long long cacheHits = 0;
+};
+
+// runFastSA on stack-resident arrays: blocks are indices, tree links are
+// index arrays with -1 for null, and nets are flattened once up front
+template <int MaxBlocks, CostMode Mode>
+class FixedAnnealer
+{
+public:
+    FixedAnnealer(Floorplanner *fp, SimulatedAnnealing &sa);
+    void run();
+
+private:
+    void runSpeculative(int threads);
+    void adopt(const FixedAnnealer &other);
+    void evaluateCandidate(const FixedAnnealer &master, unsigned long long seed, int iteration, double currentCost,
+                           bool inOutline, double temperature, EvaluationCache *cache, CandidateOutcome &outcome);
+    bool decide(bool changed, double currentCost, double threshold, double limit, bool inOutline, bool checkValidity,
+                EvaluationCache *cache, CachedEvaluation &evaluation, long long &cacheLookups, long long &cacheHits);
+    int randInt(int n) { return _candidateRng != nullptr ? _candidateRng->randInt(n) : _floorplanner->randInt(n); }
+    void pack();
+    int calcArea();
+    double calcWirelength(double partial = 0, double weight = 0, double limit = DBL_MAX);
+    double calcCost(double limit = DBL_MAX);
+    bool isValid();
+    bool rotateOperation();
+    bool moveOperation();
+    bool swapOperation();
+    bool isDescendant(int target, int dest);
+    void toggleChildLinks(int node);
+    void store(const FixedPlacement<MaxBlocks> &placement);
+    // BStarTree::getLinks layout of the current tree
+    void saveLinks(std::vector<int> &links);
+    void saveLinks(FixedLinks<MaxBlocks> &links);
+    void restoreLinks(const FixedLinks<MaxBlocks> &links);
+    void saveChainState(double runtime);
+
+    Floorplanner *_floorplanner;
+    SimulatedAnnealing &_sa;
+    int _n;
+    int _root;
+    FixedPlacement<MaxBlocks> _placement;
+    int _parent[MaxBlocks];
+    int _left[MaxBlocks];
+    int _right[MaxBlocks];
+    int _stack[MaxBlocks];
+    unsigned long long _linkHash; // Zobrist keys of the tree links, kept current by the operators
+    std::vector<int> _bestLinks; // BStarTree::getLinks layout of the best placement's tree
+
+    // net i owns pins [_netStart[i], _netStart[i + 1]); fixed terminals are folded into _netBox.
+    // nets with weight 0 are left out, chip-box nets keep no pins and span the chip extents
+    std::vector<int> _netStart;
+    std::vector<int> _netPins;
+    std::vector<double> _netBox; // minX, minY, maxX, maxY per net
+    std::vector<double> _netWeight;
+    std::vector<char> _netChipBox;
+    bool _hasChipBoxNets = false;
+    int _chipWidth = 0;
+    int _chipHeight = 0;
+    double _lastArea = 0;       // terms of the last complete calcCost, 0 where the mode skips one
+    double _lastWirelength = 0;
+    CandidateRng *_candidateRng = nullptr; // move draws of a speculative candidate, else the floorplanner's generator
+};
+
+template <int MaxBlocks, CostMode Mode>
+FixedAnnealer<MaxBlocks, Mode>::FixedAnnealer(Floorplanner *fp, SimulatedAnnealing &sa) : _floorplanner(fp), _sa(sa)
+{
+    std::vector<Block> &blocks = fp->manager._blocks;
+    _n = blocks.size();
+    for (int i = 0; i < _n; i++)
+    {
+        _placement.width[i] = blocks[i].getWidth();
+        _placement.height[i] = blocks[i].getHeight();
+        _placement.x[i] = blocks[i].getX1();
+        _placement.y[i] = blocks[i].getY1();
+        TreeNode *node = fp->getTree()->getNode(i);
+        _parent[i] = node->parent ? node->parent->blockID : -1;
+        _left[i] = node->left ? node->left->blockID : -1;
+        _right[i] = node->right ? node->right->blockID : -1;
+    }
+    _root = fp->getTree()->getRoot()->blockID;
+    _placement.rotationHash = 0;
+    _linkHash = 0;
+    for (int i = 0; i < _n; i++)
+        toggleChildLinks(i);
+
+    std::map<const Terminal *, int> blockIndex;
+    for (int i = 0; i < _n; i++)
+        blockIndex[&blocks[i]] = i;
+    for (Net &net : fp->manager._nets)
+    {
+        if (net.getWeight() == 0)
+            continue;
+        _netStart.push_back(_netPins.size());
+        _netWeight.push_back(net.getWeight());
+        _netChipBox.push_back(net.usesChipBox());
+        _hasChipBoxNets = _hasChipBoxNets || net.usesChipBox();
+        double minX = INT_MAX;
+        double minY = INT_MAX;
+        double maxX = 0.0;
+        double maxY = 0.0;
+        for (Terminal *term : net.getTermList())
+        {
+            auto block = blockIndex.find(term);
+            if (block != blockIndex.end())
+            {
+                if (!net.usesChipBox())
+                    _netPins.push_back(block->second);
+                continue;
+            }
+            minX = (term->getX1() < minX) ? term->getX1() : minX;
+            minY = (term->getY1() < minY) ? term->getY1() : minY;
+            maxX = (term->getX2() > maxX) ? term->getX2() : maxX;
+            maxY = (term->getY2() > maxY) ? term->getY2() : maxY;
+        }
+        _netBox.push_back(minX);
+        _netBox.push_back(minY);
+        _netBox.push_back(maxX);
+        _netBox.push_back(maxY);
+    }
+    _netStart.push_back(_netPins.size());
+}
+
+// same layout as BStarTree::packRest, walked with an explicit stack
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::pack()
+{
+    FixedPlacement<MaxBlocks> &p = _placement;
+    int top = 0;
+    p.x[_root] = 0;
+    p.y[_root] = 0;
+    _stack[top++] = _root;
+    while (top > 0)
+    {
+        int node = _stack[--top];
+        int left = _left[node];
+        int right = _right[node];
+        if (left != -1)
+        {
+            p.x[left] = p.x[node] + p.width[node];
+            p.y[left] = p.y[node];
+            _stack[top++] = left;
+        }
+        if (right != -1)
+        {
+            p.x[right] = p.x[node];
+            p.y[right] = p.y[node] + p.height[node];
+            _stack[top++] = right;
+        }
+    }
+}
+
+template <int MaxBlocks, CostMode Mode>
+int FixedAnnealer<MaxBlocks, Mode>::calcArea()
+{
+    int greatestX = 0;
+    int greatestY = 0;
+    for (int i = 0; i < _n; i++)
+    {
+        int right = _placement.x[i] + _placement.width[i];
+        int top = _placement.y[i] + _placement.height[i];
+        greatestX = right > greatestX ? right : greatestX;
+        greatestY = top > greatestY ? top : greatestY;
+    }
+    _chipWidth = greatestX;
+    _chipHeight = greatestY;
+    return greatestX * greatestY;
+}
+
+// stops early once partial + weight * W exceeds limit, as Floorplanner::calcCost does.
+// chip-box nets read the extents left by the last calcArea
+template <int MaxBlocks, CostMode Mode>
+double FixedAnnealer<MaxBlocks, Mode>::calcWirelength(double partial, double weight, double limit)
+{
+    const FixedPlacement<MaxBlocks> &p = _placement;
+    double W = 0;
+    for (size_t net = 0; net + 1 < _netStart.size(); net++)
+    {
+        double minX = _netBox[4 * net];
+        double minY = _netBox[4 * net + 1];
+        double maxX = _netBox[4 * net + 2];
+        double maxY = _netBox[4 * net + 3];
+        if (_netChipBox[net])
+        {
+            minX = minX < 0 ? minX : 0;
+            minY = minY < 0 ? minY : 0;
+            maxX = maxX > _chipWidth ? maxX : _chipWidth;
+            maxY = maxY > _chipHeight ? maxY : _chipHeight;
+        }
+        for (int pin = _netStart[net]; pin < _netStart[net + 1]; pin++)
+        {
+            int b = _netPins[pin];
+            minX = (p.x[b] < minX) ? p.x[b] : minX;
+            minY = (p.y[b] < minY) ? p.y[b] : minY;
+            maxX = (p.x[b] + p.width[b] > maxX) ? p.x[b] + p.width[b] : maxX;
+            maxY = (p.y[b] + p.height[b] > maxY) ? p.y[b] + p.height[b] : maxY;
+        }
+        W += _netWeight[net] * ((maxX - minX) + (maxY - minY));
+        if (partial + weight * W > limit)
+            return W;
+    }
+    return W;
+}
+
+// with alpha exactly 0 or 1 the dropped term is multiplied by zero in
+// Floorplanner::calcCost, so skipping it leaves the cost bit-identical
+template <int MaxBlocks, CostMode Mode>
+double FixedAnnealer<MaxBlocks, Mode>::calcCost(double limit)
+{
+    if (Mode == AREA_COST)
+    {
+        _lastArea = calcArea();
+        _lastWirelength = 0;
+        return _lastArea / _floorplanner->getAnorm();
+    }
+    double alpha = _floorplanner->getAlpha();
+    double A = Mode == WIRELENGTH_COST && !_hasChipBoxNets ? 0 : calcArea();
+    double partial = Mode == WIRELENGTH_COST ? 0 : alpha * (A / _floorplanner->getAnorm());
+    if (partial > limit)
+        return partial;
+    double wireWeight = (1.0 - alpha) / _floorplanner->getWnorm();
+    double W = calcWirelength(partial, wireWeight, limit);
+    if (partial + wireWeight * W > limit)
+        return partial + wireWeight * W;
+    _lastArea = A;
+    _lastWirelength = W;
+    if (Mode == WIRELENGTH_COST)
+        return W / _floorplanner->getWnorm();
+    return alpha * (A / _floorplanner->getAnorm()) + (1.0 - alpha) * (W / _floorplanner->getWnorm());
+}
+
+template <int MaxBlocks, CostMode Mode>
+bool FixedAnnealer<MaxBlocks, Mode>::isValid()
+{
+    const FixedPlacement<MaxBlocks> &p = _placement;
+    for (int i = 0; i < _n; i++)
+    {
+        if (p.x[i] + p.width[i] > _floorplanner->outlineWidth || p.y[i] + p.height[i] > _floorplanner->outlineHeight)
+            return false;
+    }
+    for (int i = 0; i < _n; i++)
+    {
+        for (int j = i + 1; j < _n; j++)
+        {
+            if (p.x[i] < p.x[j] + p.width[j] && p.x[i] + p.width[i] > p.x[j] &&
+                p.y[i] < p.y[j] + p.height[j] && p.y[i] + p.height[i] > p.y[j])
+                return false;
+        }
+    }
+    return true;
+}
+
+// the operators leave packing to run() and return false when nothing changed
+template <int MaxBlocks, CostMode Mode>
+bool FixedAnnealer<MaxBlocks, Mode>::rotateOperation()
+{
+    int blockID = randInt(_n);
+    int temp = _placement.width[blockID];
+    _placement.width[blockID] = _placement.height[blockID];
+    _placement.height[blockID] = temp;
+    _placement.rotationHash ^= zobristRotationKey(blockID);
+    return true;
+}
+
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::toggleChildLinks(int node)
+{
+    if (_left[node] != -1)
+        _linkHash ^= zobristLinkKey(node, _left[node], true);
+    if (_right[node] != -1)
+        _linkHash ^= zobristLinkKey(node, _right[node], false);
+}
+
+template <int MaxBlocks, CostMode Mode>
+bool FixedAnnealer<MaxBlocks, Mode>::isDescendant(int target, int dest)
+{
+    int top = 0;
+    _stack[top++] = target;
+    while (top > 0)
+    {
+        int node = _stack[--top];
+        if (node == dest)
+            return true;
+        if (_left[node] != -1)
+            _stack[top++] = _left[node];
+        if (_right[node] != -1)
+            _stack[top++] = _right[node];
+    }
+    return false;
+}
+
+template <int MaxBlocks, CostMode Mode>
+bool FixedAnnealer<MaxBlocks, Mode>::moveOperation()
+{
+    int target = randInt(_n);
+    int dest = randInt(_n);
+    while (target == dest || _parent[target] == -1 || isDescendant(target, dest) || (_left[dest] != -1 && _right[dest] != -1))
+    {
+        target = randInt(_n);
+        dest = randInt(_n);
+    }
+
+    int targetParent = _parent[target];
+    toggleChildLinks(targetParent);
+    if (dest != targetParent)
+        toggleChildLinks(dest);
+    if (_left[targetParent] == target)
+        _left[targetParent] = -1;
+    else if (_right[targetParent] == target)
+        _right[targetParent] = -1;
+
+    if (_left[dest] == -1 && _right[dest] == -1)
+    {
+        if (randInt(2))
+            _left[dest] = target;
+        else
+            _right[dest] = target;
+    }
+    else if (_left[dest] == -1)
+        _left[dest] = target;
+    else
+        _right[dest] = target;
+    _parent[target] = dest;
+
+    toggleChildLinks(targetParent);
+    if (dest != targetParent)
+        toggleChildLinks(dest);
+    return true;
+}
+
+template <int MaxBlocks, CostMode Mode>
+bool FixedAnnealer<MaxBlocks, Mode>::swapOperation()
+{
+    int node1 = randInt(_n);
+    int node2 = randInt(_n);
+    while (node1 == node2)
+        node2 = randInt(_n);
+    if (node1 == _root || node2 == _root)
+        return false;
+    if (_parent[node1] == node2 || _parent[node2] == node1)
+        return false;
+
+    int node1Parent = _parent[node1];
+    int node1Left = _left[node1];
+    int node1Right = _right[node1];
+    bool isLeft1 = (node1Parent != -1 && _left[node1Parent] == node1);
+    int node2Parent = _parent[node2];
+    int node2Left = _left[node2];
+    int node2Right = _right[node2];
+    bool isLeft2 = (node2Parent != -1 && _left[node2Parent] == node2);
+
+    // only the child links of the two nodes and their parents change
+    int touched[4] = {node1, node2, node1Parent, node2Parent != node1Parent ? node2Parent : -1};
+    for (int node : touched)
+        if (node != -1)
+            toggleChildLinks(node);
+
+    _parent[node1] = node2Parent;
+    _left[node1] = node2Left;
+    _right[node1] = node2Right;
+    _parent[node2] = node1Parent;
+    _left[node2] = node1Left;
+    _right[node2] = node1Right;
+
+    if (_parent[node1] != -1)
+        (isLeft2 ? _left : _right)[_parent[node1]] = node1;
+    if (_parent[node2] != -1)
+        (isLeft1 ? _left : _right)[_parent[node2]] = node2;
+    if (_left[node1] != -1)
+        _parent[_left[node1]] = node1;
+    if (_right[node1] != -1)
+        _parent[_right[node1]] = node1;
+    if (_left[node2] != -1)
+        _parent[_left[node2]] = node2;
+    if (_right[node2] != -1)
+        _parent[_right[node2]] = node2;
+
+    for (int node : touched)
+        if (node != -1)
+            toggleChildLinks(node);
+    return true;
+}
+
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::store(const FixedPlacement<MaxBlocks> &placement)
+{
+    std::vector<Block> &blocks = _floorplanner->manager._blocks;
+    for (int i = 0; i < _n; i++)
+    {
+        blocks[i].setWidth(placement.width[i]);
+        blocks[i].setHeight(placement.height[i]);
+        blocks[i].setPos(placement.x[i], placement.y[i], placement.x[i] + placement.width[i], placement.y[i] + placement.height[i]);
+    }
+}
+
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::saveLinks(std::vector<int> &links)
+{
+    links.resize(3 * _n);
+    for (int i = 0; i < _n; i++)
+    {
+        links[3 * i] = _parent[i];
+        links[3 * i + 1] = _left[i];
+        links[3 * i + 2] = _right[i];
+    }
+}
+
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::saveLinks(FixedLinks<MaxBlocks> &links)
+{
+    std::copy(_parent, _parent + _n, links.parent);
+    std::copy(_left, _left + _n, links.left);
+    std::copy(_right, _right + _n, links.right);
+    links.hash = _linkHash;
+}
+
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::restoreLinks(const FixedLinks<MaxBlocks> &links)
+{
+    std::copy(links.parent, links.parent + _n, _parent);
+    std::copy(links.left, links.left + _n, _left);
+    std::copy(links.right, links.right + _n, _right);
+    _linkHash = links.hash;
+}
+
+// hands the current state to a continuous chain, see Floorplanner::saveChainState
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::saveChainState(double runtime)
+{
+    std::vector<int> links;
+    saveLinks(links);
+    store(_placement);
+    _floorplanner->getTree()->setLinks(links);
+    _floorplanner->saveChainState(runtime);
+}
+
+// looks the perturbed state up in cache or packs and costs it, then decides the move.
+// a state the cost accepts, or any state when checkValidity is set, is packed and has
+// its validity in evaluation; evaluation.cost of a rejected state may be a lower bound.
+// with inOutline set the chain stays in the outline and rejects a state that leaves it,
+// see Floorplanner::setStayInOutline
+template <int MaxBlocks, CostMode Mode>
+bool FixedAnnealer<MaxBlocks, Mode>::decide(bool changed, double currentCost, double threshold, double limit, bool inOutline, bool checkValidity,
+                                            EvaluationCache *cache, CachedEvaluation &evaluation, long long &cacheLookups, long long &cacheHits)
+{
+    // a cached evaluation decides the move unless it is a bound the limit does not rule out
+    unsigned long long hash = _linkHash ^ _placement.rotationHash;
+    bool hit = false;
+    if (cache && changed)
+    {
+        cacheLookups++;
+        hit = cache->find(hash, evaluation) && (evaluation.complete || evaluation.cost > limit);
+    }
+    if (hit)
+    {
+        cacheHits++;
+    }
+    else
+    {
+        if (changed)
+            pack();
+        evaluation.cost = calcCost(limit);
+        evaluation.complete = evaluation.cost <= limit;
+        evaluation.area = evaluation.complete ? _lastArea : 0;
+        evaluation.wirelength = evaluation.complete ? _lastWirelength : 0;
+        evaluation.valid = -1;
+    }
+    bool costAccepted = evaluation.cost <= currentCost || evaluation.cost < threshold;
+    if (hit && costAccepted)
+        pack();
+
+    if ((costAccepted || checkValidity) && evaluation.valid < 0)
+        evaluation.valid = isValid();
+    if (cache && changed && (!hit || costAccepted))
+        cache->store(hash, evaluation);
+    return costAccepted && !(inOutline && evaluation.valid == 0);
+}
+
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::run()
+{
+    int threads = _floorplanner->getSpeculativeThreads();
+    // the archive takes every evaluated state, so it stays on the sequential chain
+    if (threads > 0 && _floorplanner->getParetoArchive() == nullptr)
+    {
+        runSpeculative(threads);
+        return;
+    }
+
+    int firstIteration = _floorplanner->getFirstIteration();
+    int maxIterations = _floorplanner->getIterationCount() > 0 ? std::min(NUM_ITERATIONS, firstIteration + _floorplanner->getIterationCount()) : NUM_ITERATIONS;
+    std::vector<Block> &blocks = _floorplanner->manager._blocks;
+
+    double currentCost = calcCost();
+    double startCost = currentCost;
+    bool initialValid = isValid();
+    double bestCost = initialValid ? currentCost : DBL_MAX;
+    FixedPlacement<MaxBlocks> bestPlacement = _placement;
+    saveLinks(_bestLinks);
+
+    int acceptedMoves = 0;
+    int validSolutions = 0;
+    bool foundValidSolution = initialValid;
+    bool stayInOutline = _floorplanner->staysInOutline();
+
+    double timeBudget = _floorplanner->getTimeBudget();
+    bool verbose = _floorplanner->isVerbose();
+    ParetoArchive *archive = _floorplanner->getParetoArchive();
+    std::unique_ptr<SnapshotWriter> snapshots = _sa.openSnapshots();
+    if (snapshots && initialValid)
+    {
+        double area = calcArea();
+        snapshots->record(0, 0, currentCost, area, calcWirelength(), blocks);
+    }
+    std::shared_ptr<TemperatureSchedule> sharedSchedule = _floorplanner->startSchedule(_sa);
+    TemperatureSchedule &schedule = *sharedSchedule;
+    // the archive needs every state's blocks, so it does without the cache
+    std::unique_ptr<EvaluationCache> cache;
+    if (_floorplanner->usesEvaluationCache() && archive == nullptr)
+        cache.reset(new EvaluationCache());
+    long long cacheLookups = 0;
+    long long cacheHits = 0;
+    auto startTime = _floorplanner->startTime();
+    double firstValidTime = initialValid ? 0 : -1;
+
+    unsigned long long allocationsBefore = threadAllocations();
+    int i = firstIteration;
+    for (; i < maxIterations; i++)
+    {
+        if (timeBudget > 0 && i % 256 == 0)
+        {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            if (elapsed > timeBudget)
+                break;
+            schedule.setProgress(elapsed / timeBudget);
+        }
+        double temperature = schedule.temperature(i + 1);
+
+        // a rejected move is undone in the links as well as in the placement, matching runFastSA
+        FixedPlacement<MaxBlocks> originalPlacement = _placement;
+        FixedLinks<MaxBlocks> originalLinks;
+        saveLinks(originalLinks);
+        int method = randInt(3);
+        bool changed;
+        if (method == 0)
+            changed = moveOperation();
+        else if (method == 1)
+            changed = swapOperation();
+        else
+            changed = rotateOperation();
+
+        double threshold = _sa.acceptanceThreshold(currentCost, temperature);
+        double limit = archive != nullptr ? DBL_MAX : std::max(threshold, currentCost);
+
+        CachedEvaluation evaluation;
+        bool accepted = decide(changed, currentCost, threshold, limit, stayInOutline && foundValidSolution, archive != nullptr, cache.get(),
+                               evaluation, cacheLookups, cacheHits);
+        double newCost = evaluation.cost;
+        bool valid = (accepted || archive != nullptr) && evaluation.valid == 1;
+        if (valid)
+        {
+            if (validSolutions++ == 0 && firstValidTime < 0)
+                firstValidTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            if (archive != nullptr)
+            {
+                store(_placement);
+                double area = calcArea();
+                archive->insert(area, _floorplanner->calcExactW(_floorplanner->manager._nets), blocks);
+            }
+        }
+
+        if (accepted)
+        {
+            currentCost = newCost;
+            acceptedMoves++;
+            if (valid && newCost < bestCost)
+            {
+                foundValidSolution = true;
+                bestCost = newCost;
+                bestPlacement = _placement;
+                saveLinks(_bestLinks);
+                if (snapshots)
+                {
+                    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                    store(_placement);
+                    double area = calcArea();
+                    snapshots->record(i + 1, elapsed, newCost, area, calcWirelength(), blocks);
+                }
+            }
+        }
+        else
+        {
+            _placement = originalPlacement;
+            restoreLinks(originalLinks);
+        }
+        schedule.record(accepted, currentCost);
+
+        if (verbose && i % 10000 == 0)
+            _sa.logProgress(i, currentCost, bestCost, isValid(), temperature, acceptedMoves, validSolutions);
+    }
+
+    unsigned long long allocations = threadAllocations() - allocationsBefore;
+    double runtime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (_floorplanner->continuesChain())
+        saveChainState(runtime);
+    store(foundValidSolution ? bestPlacement : _placement);
+    if (!foundValidSolution)
+        saveLinks(_bestLinks);
+    _floorplanner->getTree()->setLinks(_bestLinks);
+    _floorplanner->getResult().iterations = i - firstIteration;
+    _floorplanner->getResult().allocations = countsAllocations() ? (long long)allocations : -1;
+    _floorplanner->getResult().cacheLookups = cacheLookups;
+    _floorplanner->getResult().cacheHits = cacheHits;
+    _floorplanner->getResult().firstValidTime = firstValidTime;
+    _floorplanner->getResult().startCost = startCost;
+    _sa.finishRun(foundValidSolution, bestCost, currentCost, runtime, acceptedMoves, validSolutions);
+}
+
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::adopt(const FixedAnnealer &other)
+{
+    _placement = other._placement;
+    std::copy(other._parent, other._parent + _n, _parent);
+    std::copy(other._left, other._left + _n, _left);
+    std::copy(other._right, other._right + _n, _right);
+    _linkHash = other._linkHash;
+}
+
+// perturbs a copy of master's committed state with the moves drawn for iteration and
+// decides it as the sequential chain would if every earlier candidate were rejected
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::evaluateCandidate(const FixedAnnealer &master, unsigned long long seed, int iteration,
+                                                       double currentCost, bool inOutline, double temperature, EvaluationCache *cache,
+                                                       CandidateOutcome &outcome)
+{
+    adopt(master);
+    CandidateRng rng(seed, iteration);
+    _candidateRng = &rng;
+    int method = randInt(3);
+    bool changed;
+    if (method == 0)
+        changed = moveOperation();
+    else if (method == 1)
+        changed = swapOperation();
+    else
+        changed = rotateOperation();
+    _candidateRng = nullptr;
+
+    double u = rng.randUnit();
+    double threshold = u <= 0 ? DBL_MAX : currentCost - temperature * log(u);
+    outcome.cacheLookups = 0;
+    outcome.cacheHits = 0;
+    outcome.accepted = decide(changed, currentCost, threshold, std::max(threshold, currentCost), inOutline, false, cache,
+                              outcome.evaluation, outcome.cacheLookups, outcome.cacheHits);
+}
+
+// one Markov chain with the next `threads` moves evaluated at once, each against the
+// committed state on its own thread. the first accepted candidate in iteration order
+// is committed and the rest are discarded, so the chain is the one a sequential run
+// drawing the same moves would follow and does not depend on the thread count. the
+// moves come from CandidateRng rather than the run's generator, so any thread count,
+// including one left by the hardware cap, gives a different chain than run() does
+template <int MaxBlocks, CostMode Mode>
+void FixedAnnealer<MaxBlocks, Mode>::runSpeculative(int threads)
+{
+    // threads beyond the hardware's only add scheduling on top of the sequential chain
+    int cores = (int)std::thread::hardware_concurrency();
+    if (cores > 0 && threads > cores)
+    {
+        if (_floorplanner->isVerbose())
+            std::cerr << "Speculation limited to the " << cores << " hardware threads instead of " << threads << std::endl;
+        threads = cores;
+    }
+    int firstIteration = _floorplanner->getFirstIteration();
+    int maxIterations = _floorplanner->getIterationCount() > 0 ? std::min(NUM_ITERATIONS, firstIteration + _floorplanner->getIterationCount()) : NUM_ITERATIONS;
+    std::vector<Block> &blocks = _floorplanner->manager._blocks;
+
+    double currentCost = calcCost();
+    double startCost = currentCost;
+    bool initialValid = isValid();
+    double bestCost = initialValid ? currentCost : DBL_MAX;
+    FixedPlacement<MaxBlocks> bestPlacement = _placement;
+    saveLinks(_bestLinks);
+
+    int acceptedMoves = 0;
+    int validSolutions = 0;
+    bool foundValidSolution = initialValid;
+    bool stayInOutline = _floorplanner->staysInOutline();
+
+    double timeBudget = _floorplanner->getTimeBudget();
+    bool verbose = _floorplanner->isVerbose();
+    std::unique_ptr<SnapshotWriter> snapshots = _sa.openSnapshots();
+    if (snapshots && initialValid)
+    {
+        double area = calcArea();
+        snapshots->record(0, 0, currentCost, area, calcWirelength(), blocks);
+    }
+    std::shared_ptr<TemperatureSchedule> sharedSchedule = _floorplanner->startSchedule(_sa);
+    TemperatureSchedule &schedule = *sharedSchedule;
+    std::unique_ptr<EvaluationCache> cache;
+    if (_floorplanner->usesEvaluationCache())
+        cache.reset(new EvaluationCache());
+    long long cacheLookups = 0;
+    long long cacheHits = 0;
+    long long candidates = 0;
+
+    // every candidate works on its own copy; the batch fields are written before
+    // generation is bumped and read by the helpers after they see the new value
+    unsigned long long seed = ((unsigned long long)_floorplanner->randInt(INT_MAX) << 31) ^ _floorplanner->randInt(INT_MAX);
+    std::vector<std::unique_ptr<FixedAnnealer>> copies;
+    for (int k = 0; k < threads; k++)
+        copies.emplace_back(new FixedAnnealer(*this));
+    std::vector<CandidateOutcome> outcomes(threads);
+    std::vector<double> temperatures(threads);
+    int batchStart = 0;
+    int batchSize = 0;
+    double batchCost = 0;
+    SpeculationSignal generation;
+    SpeculationSignal pending;
+    std::atomic<bool> stop(false);
+    std::vector<unsigned long long> helperAllocations(threads, 0);
+    auto evaluate = [&](int k) {
+        if (k < batchSize)
+            copies[k]->evaluateCandidate(*this, seed, batchStart + k, batchCost, stayInOutline && foundValidSolution, temperatures[k], cache.get(),
+                                         outcomes[k]);
+    };
+    std::vector<std::thread> helpers;
+    for (int k = 1; k < threads; k++)
+    {
+        helpers.emplace_back([&, k] {
+            // allocation counters are per thread, so each helper reports its own
+            unsigned long long allocationsBefore = threadAllocations();
+            int seen = 0;
+            while (true)
+            {
+                generation.waitUntil([&] { return generation.value.load() != seen || stop.load(); });
+                if (stop.load())
+                    break;
+                seen = generation.value.load();
+                evaluate(k);
+                if (pending.value.fetch_sub(1) == 1)
+                    pending.notify();
+            }
+            helperAllocations[k] = threadAllocations() - allocationsBefore;
+        });
+    }
+
+    auto startTime = _floorplanner->startTime();
+    double firstValidTime = initialValid ? 0 : -1;
+    int nextCheck = firstIteration;
+    int nextLog = firstIteration;
+
+    unsigned long long allocationsBefore = threadAllocations();
+    int i = firstIteration;
+    while (i < maxIterations)
+    {
+        if (timeBudget > 0 && i >= nextCheck)
+        {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            if (elapsed > timeBudget)
+                break;
+            schedule.setProgress(elapsed / timeBudget);
+            nextCheck = i + 256;
+        }
+
+        // a candidate's temperature only matters if every earlier one is rejected,
+        // so a copy of the schedule is advanced as if they were
+        batchStart = i;
+        batchSize = std::min(threads, maxIterations - i);
+        batchCost = currentCost;
+        TemperatureSchedule lookahead(schedule);
+        for (int k = 0; k < batchSize; k++)
+        {
+            temperatures[k] = lookahead.temperature(i + k + 1);
+            lookahead.record(false, currentCost);
+        }
+        pending.value.store(threads - 1);
+        generation.value.fetch_add(1);
+        generation.notify();
+        evaluate(0);
+        pending.waitUntil([&] { return pending.value.load() == 0; });
+        candidates += batchSize;
+
+        int chosen = 0;
+        while (chosen < batchSize && !outcomes[chosen].accepted)
+            chosen++;
+        // candidates past the committed one never happened in the chain
+        for (int k = 0; k < std::min(chosen + 1, batchSize); k++)
+        {
+            cacheLookups += outcomes[k].cacheLookups;
+            cacheHits += outcomes[k].cacheHits;
+        }
+        for (int k = 0; k < chosen; k++)
+        {
+            schedule.temperature(i + 1);
+            schedule.record(false, currentCost);
+            i++;
+        }
+        double temperature = temperatures[std::min(chosen, batchSize - 1)];
+        if (chosen < batchSize)
+        {
+            const CachedEvaluation &evaluation = outcomes[chosen].evaluation;
+            adopt(*copies[chosen]);
+            schedule.temperature(i + 1);
+            currentCost = evaluation.cost;
+            acceptedMoves++;
+            bool valid = evaluation.valid == 1;
+            if (valid && validSolutions++ == 0 && firstValidTime < 0)
+                firstValidTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            if (valid && currentCost < bestCost)
+            {
+                foundValidSolution = true;
+                bestCost = currentCost;
+                bestPlacement = _placement;
+                saveLinks(_bestLinks);
+                if (snapshots)
+                {
+                    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                    store(_placement);
+                    double area = calcArea();
+                    snapshots->record(i + 1, elapsed, currentCost, area, calcWirelength(), blocks);
+                }
+            }
+            schedule.record(true, currentCost);
+            i++;
+        }
+
+        if (verbose && i >= nextLog)
+        {
+            _sa.logProgress(i, currentCost, bestCost, isValid(), temperature, acceptedMoves, validSolutions);
+            nextLog = (i / 10000 + 1) * 10000;
+        }
+    }
+
+    unsigned long long allocations = threadAllocations() - allocationsBefore;
+    double runtime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    stop.store(true);
+    generation.notify();
+    for (std::thread &helper : helpers)
+        helper.join();
+    for (unsigned long long helper : helperAllocations)
+        allocations += helper;
+
+    if (verbose)
+        std::cout << "Speculation: " << candidates << " candidates on " << threads << " threads for "
+                  << i - firstIteration << " moves" << std::endl;
+    if (_floorplanner->continuesChain())
+        saveChainState(runtime);
+    store(foundValidSolution ? bestPlacement : _placement);
+    if (!foundValidSolution)
+        saveLinks(_bestLinks);
+    _floorplanner->getTree()->setLinks(_bestLinks);
+    _floorplanner->getResult().iterations = i - firstIteration;
+    _floorplanner->getResult().allocations = countsAllocations() ? (long long)allocations : -1;
+    _floorplanner->getResult().cacheLookups = cacheLookups;
+    _floorplanner->getResult().cacheHits = cacheHits;
+    _floorplanner->getResult().firstValidTime = firstValidTime;
+    _floorplanner->getResult().startCost = startCost;
+    _sa.finishRun(foundValidSolution, bestCost, currentCost, runtime, acceptedMoves, validSolutions);
+}
+
+template <int MaxBlocks>
+static bool runCostMode(Floorplanner *fp, SimulatedAnnealing &sa)
+{
+    if (fp->getAlpha() == 1.0)
+        FixedAnnealer<MaxBlocks, AREA_COST>(fp, sa).run();
+    else if (fp->getAlpha() == 0.0)
+        FixedAnnealer<MaxBlocks, WIRELENGTH_COST>(fp, sa).run();
+    else
+        FixedAnnealer<MaxBlocks, BLENDED_COST>(fp, sa).run();
+    return true;
+}
+
+bool runFixedSizeSA(Floorplanner *fp, SimulatedAnnealing &sa)
+{
+    int n = fp->manager._blocks.size();
+    // the move operator needs a second block to move under
+    if (n < 2 || n > FIXED_SA_MAX_BLOCKS || n > 64)
+        return false;
+    if (n <= 16)
+        return runCostMode<16>(fp, sa);
+    if (n <= 32)
+        return runCostMode<32>(fp, sa);
+    return runCostMode<64>(fp, sa);
+}
@@ -2,21 +2,179 @@
 #include "floorplanner.h"
 #include "simulatedAnnealing.h"
 #include "BStarTree.h"
+#include "paretoArchive.h"
+#include "snapshotWriter.h"
+#include "fixedAnnealer.h"
+#include "temperatureSchedule.h"
+#include "initialFloorplan.h"
+#include "refiner.h"
+#include "allocationCounter.h"
+#include "evaluationCache.h"
+#include <cctype>
+#include <cfloat>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+
+Floorplanner::Floorplanner(double alpha, const Design& design) : manager(design.manager), outlineHeight(design.outlineHeight), outlineWidth(design.outlineWidth), _alpha(alpha)
+{
+    setNormalization(design.normalization);
+}
 
 void Floorplanner::floorplan()
+{
+    if (_input_blk != nullptr && _input_net != nullptr)
+        loadDesign();
+    prepare();
+    anneal();
+}
+
+// anneals from the current tree and blocks, which then hold the best floorplan found
+void Floorplanner::anneal()
+{
+    _refinedMoves = 0;
+    if (_continuousChain && _chainSaved) {
+        tree.setLinks(_chainLinks);
+        restoreGeometry(manager._blocks, _chainGeometry);
+    }
+    SimulatedAnnealing SA(this);
+    if (!_fixedEngine || !runFixedSizeSA(this, SA))
+        SA.runFastSA();
+}
+
+void Floorplanner::setContinuousChain(bool continuous)
+{
+    _continuousChain = continuous;
+    _chainSaved = false;
+    _chainTime = 0;
+    _chainSchedule.reset();
+}
+
+void Floorplanner::saveChainState(double runtime)
+{
+    tree.getLinks(_chainLinks);
+    saveGeometry(manager._blocks, _chainGeometry);
+    _chainTime = runtime;
+    _chainSaved = true;
+}
+
+std::shared_ptr<TemperatureSchedule> Floorplanner::startSchedule(SimulatedAnnealing& sa)
+{
+    if (_continuousChain && _chainSchedule)
+        return _chainSchedule;
+    std::shared_ptr<TemperatureSchedule> schedule = std::make_shared<TemperatureSchedule>(sa, _schedule, NUM_ITERATIONS);
+    if (_continuousChain)
+        _chainSchedule = schedule;
+    return schedule;
+}
+
+std::chrono::steady_clock::time_point Floorplanner::startTime()
+{
+    auto spent = std::chrono::duration<double>(_continuousChain ? _chainTime : 0);
+    return std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(spent);
+}
+
+bool Floorplanner::loadDesign()
 {
     bool blockReadSuccess;
     bool netReadSuccess;
-    blockReadSuccess = readBlockFile(_input_blk);
-    netReadSuccess = readNetFile(_input_net);
-    tree.buildTree(manager._blocks);
+    blockReadSuccess = readBlockFile(*_input_blk);
+    netReadSuccess = readNetFile(*_input_net);
+    preprocessNets();
+    return blockReadSuccess && netReadSuccess;
+}
+
+// builds the initial tree and, unless a cached normalization was supplied, samples it.
+// the sample draws from NORMALIZATION_SEED rather than the run's seed, so a design
+// normalizes alike in every run, cached or not, and the run's seed drives only the anneal
+void Floorplanner::prepare()
+{
+    if (_constructiveStart)
+        buildInitialTree();
+    else
+        tree.buildTree(manager._blocks);
     tree.packFloorplan(manager._blocks);
-    calcPerturbations();
-    SimulatedAnnealing SA(this);
-    SA.runFastSA();
+    if (!_normalized) {
+        std::mt19937 runRng = _rng;
+        _rng.seed(NORMALIZATION_SEED);
+        calcPerturbations();
+        _rng = runRng;
+    }
+}
+
+// shelf-packs the blocks into the outline width, in cluster-growth order when
+// that fits the outline height and otherwise in whichever order stacks lower
+void Floorplanner::buildInitialTree()
+{
+    std::vector<std::vector<int>> orders = {clusterOrder(manager), heightOrder(manager._blocks)};
+    std::vector<std::vector<int>> rows;
+    std::vector<std::vector<int>> bestRows;
+    std::vector<Block> bestBlocks;
+    int bestHeight = INT_MAX;
+    size_t bestOrder = 0;
+    for (size_t i = 0; i < orders.size(); i++) {
+        std::vector<Block> blocks = manager._blocks;
+        int height = planShelves(blocks, orders[i], outlineWidth, rows);
+        if (height < bestHeight) {
+            bestHeight = height;
+            bestRows = rows;
+            bestBlocks = blocks;
+            bestOrder = i;
+        }
+        if (height <= outlineHeight) break;
+    }
+    manager._blocks = bestBlocks;
+    tree.buildShelves(bestRows, manager._blocks.size());
+    if (_verbose) {
+        std::cout << "Initial floorplan: " << bestRows.size() << " rows, height " << bestHeight
+                  << " of " << outlineHeight << (bestOrder == 0 ? " (cluster order)" : " (height order)") << std::endl;
+    }
 }
 
+void Floorplanner::setNormalization(const NormalizationStats& stats)
+{
+    _normalization = stats;
+    Anorm = stats.Anorm;
+    Wnorm = stats.Wnorm;
+    averageUphillCost = stats.averageUphillCost(_alpha);
+    _normalized = true;
+}
+
+double NormalizationStats::averageUphillCost(double alpha) const
+{
+    double total = 0;
+    int uphill = 0;
+    for (const auto& delta : deltas) {
+        double deltaCost = alpha * delta.first + (1.0 - alpha) * delta.second;
+        if (deltaCost > 0) {
+            total += deltaCost;
+            uphill++;
+        }
+    }
+    return uphill != 0 ? total / uphill : 0;
+}
+
+// wirelength under the net model; chip-box nets use the extents from the last calcA
 double Floorplanner::calcW(std::vector<Net> &nets)
+{
+    double W = 0;
+    for (Net &net : nets)
+    {
+        if (net.getWeight() != 0)
+            W += calcNetW(net);
+    }
+    return W;
+}
+
+double Floorplanner::calcNetW(Net &net)
+{
+    double hpwl = net.usesChipBox() ? net.calcChipBoxHPWL(_chipWidth, _chipHeight) : net.calcHPWL();
+    return net.getWeight() * hpwl;
+}
+
+// plain HPWL over every net, used for reports
+double Floorplanner::calcExactW(std::vector<Net> &nets)
 {
     double W = 0;
     for (Net &net : nets)
@@ -26,6 +184,106 @@ double Floorplanner::calcW(std::vector<Net> &nets)
     return W;
 }
 
+// a supply name followed by nothing but an optional number and an optional "!",
+// so VDD, VSS2 and GND! match while VDDIO_SENSE, VCCx and GNDREF_BUF do not
+static bool isSupplyName(const std::string &name)
+{
+    static const char *supplies[] = {"GND", "VDD", "VSS", "VCC"};
+    for (const char *supply : supplies)
+    {
+        size_t length = strlen(supply);
+        if (name.compare(0, length, supply) != 0)
+            continue;
+        size_t end = name.size() - (name.back() == '!');
+        while (length < end && isdigit((unsigned char)name[length]))
+            length++;
+        return length == end;
+    }
+    return false;
+}
+
+// classifies nets by degree and applies the net model: supply nets and nets of
+// at least highFanoutDegree pins get their weight, nets touching every block
+// (and, if enabled, high-fanout nets) are evaluated against the chip box
+void Floorplanner::preprocessNets()
+{
+    int supplyNets = 0;
+    int highFanoutNets = 0;
+    int chipBoxNets = 0;
+    int droppedNets = 0;
+    std::vector<int> degreeCounts;
+    std::map<const Terminal *, int> blockIndex;
+    for (size_t i = 0; i < manager._blocks.size(); i++)
+        blockIndex[&manager._blocks[i]] = i;
+    for (Net &net : manager._nets)
+    {
+        std::vector<Terminal *> terms = net.getTermList();
+        int degree = terms.size();
+        int bucket = 0;
+        while ((2 << bucket) <= degree)
+            bucket++;
+        if ((int)degreeCounts.size() <= bucket)
+            degreeCounts.resize(bucket + 1, 0);
+        degreeCounts[bucket]++;
+
+        bool supply = false;
+        std::vector<bool> blockPinned(manager._blocks.size(), false);
+        int blockPins = 0;
+        double minX = INT_MAX;
+        double minY = INT_MAX;
+        double maxX = 0.0;
+        double maxY = 0.0;
+        for (Terminal *term : terms)
+        {
+            supply = supply || isSupplyName(term->getName());
+            auto block = blockIndex.find(term);
+            if (block != blockIndex.end())
+            {
+                blockPins += !blockPinned[block->second];
+                blockPinned[block->second] = true;
+                continue;
+            }
+            minX = (term->getX1() < minX) ? term->getX1() : minX;
+            minY = (term->getY1() < minY) ? term->getY1() : minY;
+            maxX = (term->getX2() > maxX) ? term->getX2() : maxX;
+            maxY = (term->getY2() > maxY) ? term->getY2() : maxY;
+        }
+
+        bool highFanout = _netModel.highFanoutDegree > 0 && degree >= _netModel.highFanoutDegree;
+        if (supply)
+        {
+            net.setWeight(_netModel.supplyWeight);
+            supplyNets++;
+        }
+        else if (highFanout)
+        {
+            net.setWeight(_netModel.highFanoutWeight);
+        }
+        highFanoutNets += highFanout;
+
+        bool spansAllBlocks = blockPins == (int)manager._blocks.size() && blockPins > 0;
+        if (spansAllBlocks || (highFanout && _netModel.approximateHighFanout))
+        {
+            net.setChipBox(minX, minY, maxX, maxY);
+            chipBoxNets++;
+        }
+        droppedNets += net.getWeight() == 0;
+    }
+
+    if (_verbose)
+    {
+        std::cout << "Nets by degree:";
+        for (size_t bucket = 0; bucket < degreeCounts.size(); bucket++)
+        {
+            if (degreeCounts[bucket] != 0)
+                std::cout << " [" << (1 << bucket) << "," << (2 << bucket) << "): " << degreeCounts[bucket];
+        }
+        std::cout << std::endl;
+        std::cout << "Supply nets: " << supplyNets << ", high-fanout nets: " << highFanoutNets
+                  << ", chip-box nets: " << chipBoxNets << ", dropped nets: " << droppedNets << std::endl;
+    }
+}
+
 double Floorplanner::calcA(std::vector<Block> &blocks) {
     int greatestX = 0;
     int greatestY = 0;
@@ -37,6 +295,8 @@ double Floorplanner::calcA(std::vector<Block> &blocks) {
             greatestY = blocks[i].getY1() + blocks[i].getHeight();
         }
     }
+    _chipWidth = greatestX;
+    _chipHeight = greatestY;
     return greatestX * greatestY;
 }
 
@@ -47,20 +307,24 @@ void Floorplanner::calcPerturbations() {
 
     int m = manager._blocks.size() * 10;
     BStarTree original = tree;
+    std::vector<int> originalLinks = tree.getLinks();
     std::vector<Block> originalBlocks = manager._blocks;
     
       // DEBUG: Print initial state
-    std::cout << "=== DEBUG calcPerturbations ===" << std::endl;
-    std::cout << "Number of blocks: " << manager._blocks.size() << std::endl;
-    std::cout << "Number of perturbations (m): " << m << std::endl;
+    if (_verbose) {
+        std::cout << "=== DEBUG calcPerturbations ===" << std::endl;
+        std::cout << "Number of blocks: " << manager._blocks.size() << std::endl;
+        std::cout << "Number of perturbations (m): " << m << std::endl;
+    }
     // Anorm and Wnorm calcs
     for (int i = 0; i < m; i++) {
         tree = original;
+        tree.setLinks(originalLinks);
         manager._blocks = originalBlocks;
         
-        int operation = rand() % 3;
+        int operation = randInt(3);
         if (operation == 0) {
-            rotateOperation(*getTree(), manager._blocks);
+            rotateOperation(manager._blocks);
         } else if (operation == 1) {
             moveOperation(*getTree(), manager._blocks);
         } else {
@@ -78,19 +342,26 @@ void Floorplanner::calcPerturbations() {
 
 
     tree = original;
+    tree.setLinks(originalLinks);
     manager._blocks = originalBlocks;
     //tree.packFloorplan(manager._blocks);
     double costBefore = calcCost();  // Now this is the cost of the original state
+    double areaBefore = calcA(manager._blocks);
+    double wirelengthBefore = calcW(manager._nets);
+    _normalization.Anorm = Anorm;
+    _normalization.Wnorm = Wnorm;
+    _normalization.deltas.clear();
     
-    std::cout << "Initial cost: " << costBefore << std::endl;  // Move print here
+    if (_verbose) std::cout << "Initial cost: " << costBefore << std::endl;  // Move print here
     
      for (int i = 0; i < m; i++) {
         tree = original;
+        tree.setLinks(originalLinks);
         manager._blocks = originalBlocks;
         //tree.packFloorplan(manager._blocks);
-        int operation = rand() % 3;
+        int operation = randInt(3);
         if (operation == 0) {
-            rotateOperation(*getTree(), manager._blocks);
+            rotateOperation(manager._blocks);
         } else if (operation == 1) {
             moveOperation(*getTree(), manager._blocks);
         } else {
@@ -103,8 +374,9 @@ void Floorplanner::calcPerturbations() {
         double currentArea = calcA(manager._blocks);
         double currentWirelength = calcW(manager._nets);
         double deltaCost = costAfter - costBefore;
+        _normalization.deltas.emplace_back((currentArea - areaBefore) / Anorm, (currentWirelength - wirelengthBefore) / Wnorm);
         // DEBUG: Print first few perturbations
-        if (i < 10) {
+        if (_verbose && i < 10) {
             std::cout << "Perturbation " << i << ": " 
                      << "operation=" << operation 
                      << ", costBefore=" << costBefore 
@@ -115,25 +387,47 @@ void Floorplanner::calcPerturbations() {
         if (deltaCost > 0) uphillCosts.push_back(deltaCost);
     }
     
+    averageUphillCost = _normalization.averageUphillCost(_alpha);
+    _normalized = true;
+
       // DEBUG: Print results
-    std::cout << "Total uphillCosts found: " << uphillCosts.size() << " out of " << m << std::endl;
-    std::cout << "Anorm: " << Anorm << std::endl;
-    std::cout << "Wnorm: " << Wnorm << std::endl;
-    for (int i = 0; i < uphillCosts.size(); i++) {
-        averageUphillCost += uphillCosts[i];
+    if (_verbose) {
+        std::cout << "Total uphillCosts found: " << uphillCosts.size() << " out of " << m << std::endl;
+        std::cout << "Anorm: " << Anorm << std::endl;
+        std::cout << "Wnorm: " << Wnorm << std::endl;
+        std::cout << "Final averageUphillCost: " << averageUphillCost << std::endl;
+        std::cout << "=== END DEBUG ===" << std::endl;
     }
-    if (uphillCosts.size() != 0) averageUphillCost /= uphillCosts.size();
-    
-std::cout << "Final averageUphillCost: " << averageUphillCost << std::endl;
-    std::cout << "=== END DEBUG ===" << std::endl;
     tree = original;
+    tree.setLinks(originalLinks);
     manager._blocks = originalBlocks;
     tree.packFloorplan(manager._blocks);
 }
 
+// stops once the partial cost exceeds limit and returns that partial sum;
+// the area term comes first because it is far cheaper than the HPWL sum
+double Floorplanner::calcCost(double limit) {
+    double A = calcA(manager._blocks);
+    double partial = _alpha * (A / Anorm);
+    if (partial > limit) return partial;
+    double wireWeight = (1.0 - _alpha) / Wnorm;
+    double W = 0;
+    for (Net &net : manager._nets) {
+        if (net.getWeight() == 0) continue;
+        W += calcNetW(net);
+        if (partial + wireWeight * W > limit) return partial + wireWeight * W;
+    }
+    _lastArea = A;
+    _lastWirelength = W;
+    
+    return _alpha * (A / Anorm) + (1.0 - _alpha) * (W / Wnorm);
+}
+
 double Floorplanner::calcCost() {
     double A = calcA(manager._blocks);
     double W = calcW(manager._nets);
+    _lastArea = A;
+    _lastWirelength = W;
     
     return _alpha * (A / Anorm) + (1.0 - _alpha) * (W / Wnorm);
 }
@@ -155,9 +449,9 @@ double Net::calcHPWL()
     return ((maxX - minX)) + ((maxY) - (minY));
 }
 
-bool Floorplanner::readBlockFile(std::ifstream &input_blk)
+bool Floorplanner::readBlockFile(std::istream &input_blk)
 {
-    if (!input_blk.is_open())
+    if (!input_blk)
         return false;
     std::string temp;
     int numBlocks;
@@ -203,9 +497,9 @@ bool Floorplanner::readBlockFile(std::ifstream &input_blk)
     return true;
 }
 
-bool Floorplanner::readNetFile(std::ifstream &input_net)
+bool Floorplanner::readNetFile(std::istream &input_net)
 {
-    if (!input_net.is_open())
+    if (!input_net)
         return false;
 
     std::string temp;
@@ -242,6 +536,26 @@ bool Floorplanner::readNetFile(std::ifstream &input_net)
     return true;
 }
 
+PlacementManager &PlacementManager::operator=(const PlacementManager &other)
+{
+    if (this == &other)
+        return *this;
+    _blocks = other._blocks;
+    _terminals = other._terminals;
+    _nets.clear();
+    for (const Net &net : other._nets)
+    {
+        _nets.emplace_back();
+        _nets.back().copyModel(net);
+        // terms point into other's storage, so resolve them again by name
+        for (Terminal *term : const_cast<Net &>(net).getTermList())
+        {
+            _nets.back().addTerm(findTerminal(term->getName()));
+        }
+    }
+    return *this;
+}
+
 void PlacementManager::printInformation()
 {
     std::cout << "Terminal size is " << _terminals.size() << std::endl;
@@ -276,6 +590,7 @@ void BStarTree::buildTree(const std::vector<Block> &blocks)
     {
         nodes.push_back(new TreeNode(i));
     }
+    root = nodes.empty() ? nullptr : nodes[0];
 
     for (int i = 0; i < nodes.size() / 2; i++)
     {
@@ -295,6 +610,90 @@ void BStarTree::buildTree(const std::vector<Block> &blocks)
     }
 }
 
+// each row is a chain of left children hanging off its first block, and the
+// first block of every row is the right child of the previous row's first block
+void BStarTree::buildShelves(const std::vector<std::vector<int>> &rows, int blockCount)
+{
+    for (int i = 0; i < blockCount; i++)
+    {
+        nodes.push_back(new TreeNode(i));
+    }
+    root = nullptr;
+    TreeNode *rowStart = nullptr;
+    for (const std::vector<int> &row : rows)
+    {
+        TreeNode *prev = nullptr;
+        for (int id : row)
+        {
+            TreeNode *node = nodes[id];
+            if (prev != nullptr)
+            {
+                prev->left = node;
+                node->parent = prev;
+            }
+            else if (rowStart != nullptr)
+            {
+                rowStart->right = node;
+                node->parent = rowStart;
+            }
+            else
+            {
+                root = node;
+            }
+            prev = node;
+        }
+        if (!row.empty())
+            rowStart = nodes[row.front()];
+    }
+}
+
+std::vector<int> BStarTree::getLinks()
+{
+    std::vector<int> links;
+    getLinks(links);
+    return links;
+}
+
+// fills links in place, so a buffer that already has room is not reallocated
+void BStarTree::getLinks(std::vector<int> &links)
+{
+    links.resize(3 * nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        links[3 * i] = nodes[i]->parent ? nodes[i]->parent->blockID : -1;
+        links[3 * i + 1] = nodes[i]->left ? nodes[i]->left->blockID : -1;
+        links[3 * i + 2] = nodes[i]->right ? nodes[i]->right->blockID : -1;
+    }
+}
+
+void BStarTree::setLinks(const std::vector<int> &links)
+{
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        nodes[i]->parent = links[3 * i] >= 0 ? nodes[links[3 * i]] : nullptr;
+        nodes[i]->left = links[3 * i + 1] >= 0 ? nodes[links[3 * i + 1]] : nullptr;
+        nodes[i]->right = links[3 * i + 2] >= 0 ? nodes[links[3 * i + 2]] : nullptr;
+        if (nodes[i]->parent == nullptr)
+            root = nodes[i];
+    }
+}
+
+void BStarTree::rehashLinks()
+{
+    linkHash = 0;
+    for (TreeNode *node : nodes)
+        toggleChildLinks(node);
+}
+
+// flips the keys of node's links to its children in or out of the hash
+void BStarTree::toggleChildLinks(TreeNode *node)
+{
+    if (node->left != nullptr)
+        linkHash ^= zobristLinkKey(node->blockID, node->left->blockID, true);
+    if (node->right != nullptr)
+        linkHash ^= zobristLinkKey(node->blockID, node->right->blockID, false);
+}
+
 void BStarTree::printTree(TreeNode *root)
 {
     if (root == nullptr)
@@ -331,29 +730,33 @@ void BStarTree::packRest(TreeNode *node, std::vector<Block> &blocks, int x, int
     }
 }
 
+// the perturbation operators leave packing to the caller and return false
+// when they changed nothing, so a cached state need not be packed at all
+
 // rotates a block 90 degrees (swaps width and height)
-void Floorplanner::rotateOperation(BStarTree &tree, std::vector<Block> &blocks)
+bool Floorplanner::rotateOperation(std::vector<Block> &blocks)
 {
-    int blockID = rand() % blocks.size();
+    int blockID = randInt(blocks.size());
     Block &block = blocks[blockID];
     int temp = block.getWidth();
     block.setWidth(block.getHeight());
     block.setHeight(temp);
     //std::cout << blockID << "'s dimensions have been switched" << std::endl;
-    tree.packFloorplan(blocks);
+    _rotationHash ^= zobristRotationKey(blockID);
+    return true;
 }
 
-void Floorplanner::moveOperation(BStarTree &tree, std::vector<Block> &blocks)
+bool Floorplanner::moveOperation(BStarTree &tree, std::vector<Block> &blocks)
 {
-    int targetID = rand() % blocks.size();
-    int destID = rand() % blocks.size();
+    int targetID = randInt(blocks.size());
+    int destID = randInt(blocks.size());
     TreeNode *target = tree.getNode(targetID);
     TreeNode *dest = tree.getNode(destID);
 
     while (target == dest || target->parent == nullptr || isDescendant(target, dest) || (dest->left != nullptr && dest->right != nullptr))
     {
-        targetID = rand() % blocks.size();
-        destID = rand() % blocks.size();
+        targetID = randInt(blocks.size());
+        destID = randInt(blocks.size());
         target = tree.getNode(targetID);
         dest = tree.getNode(destID);
     }
@@ -362,6 +765,10 @@ void Floorplanner::moveOperation(BStarTree &tree, std::vector<Block> &blocks)
     TreeNode *targetRight = target->right;
     TreeNode *targetParent = target->parent;
 
+    tree.toggleChildLinks(targetParent);
+    if (dest != targetParent)
+        tree.toggleChildLinks(dest);
+
     if (targetParent->left == target)
         targetParent->left = nullptr;
     else if (targetParent->right == target)
@@ -369,7 +776,7 @@ void Floorplanner::moveOperation(BStarTree &tree, std::vector<Block> &blocks)
 
     if (dest->left == nullptr && dest->right == nullptr)
     {
-        if (rand() % 2) {
+        if (randInt(2)) {
             dest->left = target;
         }
 
@@ -383,7 +790,10 @@ void Floorplanner::moveOperation(BStarTree &tree, std::vector<Block> &blocks)
     }
     target->parent = dest;
 
-    tree.packFloorplan(blocks);
+    tree.toggleChildLinks(targetParent);
+    if (dest != targetParent)
+        tree.toggleChildLinks(dest);
+    return true;
 }
 
 bool Floorplanner::isDescendant(TreeNode* target, TreeNode* dest)
@@ -397,36 +807,38 @@ bool Floorplanner::isDescendant(TreeNode* target, TreeNode* dest)
     return isDescendant(target->left, dest) || isDescendant(target->right, dest);
 }
 
-void Floorplanner::swapOperation(BStarTree& tree, std::vector<Block>& blocks) {
+bool Floorplanner::swapOperation(BStarTree& tree, std::vector<Block>& blocks) {
     if (blocks.size() < 2) {
-        return;
+        return false;
     }
     
-    int node1_ID = rand() % blocks.size();
-    int node2_ID = rand() % blocks.size();
+    int node1_ID = randInt(blocks.size());
+    int node2_ID = randInt(blocks.size());
     
     while (node1_ID == node2_ID) {
-        node2_ID = rand() % blocks.size();
+        node2_ID = randInt(blocks.size());
     }
     
-    if (node1_ID == 0 || node2_ID == 0) {
-        return;
+    // the root stays put, BStarTree::packFloorplan always starts from it
+    int rootID = tree.getRoot()->blockID;
+    if (node1_ID == rootID || node2_ID == rootID) {
+        return false;
     }
     
     if (node1_ID >= (int)tree.getNodes().size() || node2_ID >= (int)tree.getNodes().size() ||
         node1_ID < 0 || node2_ID < 0) {
-        return;
+        return false;
     }
     
     TreeNode* node1 = tree.getNodes()[node1_ID];
     TreeNode* node2 = tree.getNodes()[node2_ID];
     
     if (node1 == nullptr || node2 == nullptr) {
-        return;
+        return false;
     }
     
     if (node1->parent == node2 || node2->parent == node1) {
-        return;
+        return false;
     }
     
     TreeNode* node1Parent = node1->parent;
@@ -440,6 +852,12 @@ void Floorplanner::swapOperation(BStarTree& tree, std::vector<Block>& blocks) {
     TreeNode* node2Right = node2->right;
     bool isLeft2 = (node2Parent != nullptr && node2Parent->left == node2);
     
+    // only the child links of the two nodes and their parents change
+    TreeNode* touched[4] = {node1, node2, node1Parent, node2Parent != node1Parent ? node2Parent : nullptr};
+    for (TreeNode* node : touched) {
+        if (node != nullptr) tree.toggleChildLinks(node);
+    }
+    
     node1->parent = node2Parent;
     node1->left = node2Left;
     node1->right = node2Right;
@@ -477,142 +895,294 @@ void Floorplanner::swapOperation(BStarTree& tree, std::vector<Block>& blocks) {
         node2->right->parent = node2;
     }
     
-    tree.packFloorplan(blocks);
+    for (TreeNode* node : touched) {
+        if (node != nullptr) tree.toggleChildLinks(node);
+    }
+    return true;
+}
+
+double SimulatedAnnealing::fastSATemperature(int n)
+{
+    double averageUphillCost = _floorplanner->getAverageUphillCost();
+    double P = FAST_SA_P;
+    double T1 = averageUphillCost / -log(P);
+    int c = FAST_SA_C;
+    int k = FAST_SA_K;
+
+    if (n == 1) {
+        return averageUphillCost / -log(P);
+    } else if (n >= 2 && n <= k) {
+        double deltaCost = averageUphillCost * 0.1;
+        return T1 * deltaCost / (n * c);
+    } else {
+        double deltaCost = averageUphillCost * 0.1;
+        return T1 * deltaCost / n;
+    }
+}
+
+std::unique_ptr<SnapshotWriter> SimulatedAnnealing::openSnapshots()
+{
+    std::unique_ptr<SnapshotWriter> snapshots;
+    if (!_floorplanner->getSnapshotPath().empty()) {
+        snapshots.reset(new SnapshotWriter(_floorplanner->getSnapshotPath(), _floorplanner->outlineWidth, _floorplanner->outlineHeight, _floorplanner->manager._blocks));
+        if (!snapshots->isOpen() && _floorplanner->isVerbose())
+            std::cerr << "Cannot open the snapshot file \"" << _floorplanner->getSnapshotPath() << "\"" << std::endl;
+    }
+    return snapshots;
+}
+
+void SimulatedAnnealing::logProgress(int i, double currentCost, double bestCost, bool currentValid, double temperature, int acceptedMoves, int validSolutions)
+{
+    double acceptanceRate = (double)acceptedMoves / (i + 1) * 100;
+    double validRate = (double)validSolutions / (i + 1) * 100;
+
+    std::cout << "Iteration " << i 
+             << ", Current Cost: " << currentCost 
+             << ", Best Cost: " << bestCost
+             << ", Valid: " << currentValid
+             << ", Temp: " << temperature
+             << ", Accept%: " << acceptanceRate
+             << ", Valid%: " << validRate << std::endl;
 }
 
 void SimulatedAnnealing::runFastSA()
 {
     double temperature;
-    int maxIterations = NUM_ITERATIONS;
+    int firstIteration = _floorplanner->getFirstIteration();
+    int maxIterations = _floorplanner->getIterationCount() > 0 ? std::min(NUM_ITERATIONS, firstIteration + _floorplanner->getIterationCount()) : NUM_ITERATIONS;
     
     BStarTree* tree = _floorplanner->getTree();
     std::vector<Block>& blocks = _floorplanner->manager._blocks;
     
     double currentCost = _floorplanner->calcCost();
-    double bestCost = currentCost;
+    double startCost = currentCost;
+    // the best solution must be valid, so an invalid starting point never counts
+    bool initialValid = checkOutlineValidity() && !checkOverlap();
+    double bestCost = initialValid ? currentCost : DBL_MAX;
     
-    std::vector<Block> currentBlocks = blocks;
-    std::vector<Block> bestBlocks = currentBlocks;
-    BStarTree currentTree = *tree;
-    BStarTree bestTree = *tree;
+    // every buffer the loop touches is sized here, so steady-state iterations
+    // never allocate. blocks are saved without their names, and since tree
+    // copies share their nodes the best structure is kept as links
+    std::vector<BlockGeometry> originalGeometry;
+    std::vector<BlockGeometry> bestGeometry;
+    saveGeometry(blocks, originalGeometry);
+    saveGeometry(blocks, bestGeometry);
+    std::vector<int> bestLinks;
+    tree->getLinks(bestLinks);
+    std::vector<int> originalLinks;
+    tree->getLinks(originalLinks);
     
     int acceptedMoves = 0;
     int validSolutions = 0;
-    bool foundValidSolution = false;
+    bool foundValidSolution = initialValid;
 
-    double averageUphillCost = _floorplanner->getAverageUphillCost();
-    double P = FAST_SA_P;
-    double T1 = averageUphillCost / -log(P);
-    int c = FAST_SA_C;
-    int k = FAST_SA_K;
-    clock_t startTime = clock();
+    double timeBudget = _floorplanner->getTimeBudget();
+    bool verbose = _floorplanner->isVerbose();
+    ParetoArchive* archive = _floorplanner->getParetoArchive();
+    bool stayInOutline = _floorplanner->staysInOutline();
+    std::unique_ptr<SnapshotWriter> snapshots = openSnapshots();
+    if (snapshots && initialValid)
+        snapshots->record(0, 0, currentCost, _floorplanner->getLastArea(), _floorplanner->getLastWirelength(), blocks);
+    std::shared_ptr<TemperatureSchedule> sharedSchedule = _floorplanner->startSchedule(*this);
+    TemperatureSchedule& schedule = *sharedSchedule;
+    // the archive needs every state's blocks, so it does without the cache
+    std::unique_ptr<EvaluationCache> cache;
+    if (_floorplanner->usesEvaluationCache() && archive == nullptr)
+        cache.reset(new EvaluationCache());
+    tree->rehashLinks();
+    _floorplanner->setRotationHash(0);
+    long long cacheLookups = 0;
+    long long cacheHits = 0;
+    auto startTime = _floorplanner->startTime();
+    double firstValidTime = initialValid ? 0 : -1;
     
-    for (int i = 0; i < maxIterations; i++) {
-
-        // fast-sa temperature calculations
-        int n = i + 1;
-        if (n == 1) {
-            temperature = averageUphillCost / -log(P);
-        } else if (n >= 2 && n <= k) {
-            double deltaCost = averageUphillCost * 0.1;
-            temperature = T1 * deltaCost / (n * c);
-        } else {
-            double deltaCost = averageUphillCost * 0.1;
-            temperature = T1 * deltaCost / n;
+    unsigned long long allocationsBefore = threadAllocations();
+    int i = firstIteration;
+    for (; i < maxIterations; i++) {
+        if (timeBudget > 0 && i % 256 == 0) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            if (elapsed > timeBudget) break;
+            schedule.setProgress(elapsed / timeBudget);
         }
 
-        // block operations
-        std::vector<Block> originalBlocks = blocks;
-        BStarTree originalTree = *tree;
+        temperature = schedule.temperature(i + 1);
 
-        int method = rand() % 3;
-        if (method == 0) _floorplanner->moveOperation(*tree, blocks);
-        else if (method == 1) _floorplanner->swapOperation(*tree, blocks);
-        else if (method == 2) _floorplanner->rotateOperation(*tree, blocks);
-        
-        double newCost = _floorplanner->calcCost();
+        // block operations; a rejected move is undone in the tree as well as in the
+        // blocks, or the tree would drift away from the floorplan it has to describe
+        saveGeometry(blocks, originalGeometry);
+        tree->getLinks(originalLinks);
+        unsigned long long originalLinkHash = tree->getLinkHash();
+        unsigned long long originalRotations = _floorplanner->getRotationHash();
+
+        int method = _floorplanner->randInt(3);
+        bool changed = true;
+        if (method == 0) changed = _floorplanner->moveOperation(*tree, blocks);
+        else if (method == 1) changed = _floorplanner->swapOperation(*tree, blocks);
+        else if (method == 2) changed = _floorplanner->rotateOperation(blocks);
         
+        // the acceptance draw comes first so evaluation can stop as soon as
+        // the partial cost rules the move out; the archive needs every cost
+        double threshold = acceptanceThreshold(currentCost, temperature);
+        double limit = archive != nullptr ? DBL_MAX : std::max(threshold, currentCost);
+
+        // a cached evaluation decides the move unless it is a bound the limit does not rule out
+        unsigned long long hash = tree->getLinkHash() ^ _floorplanner->getRotationHash();
+        CachedEvaluation evaluation;
+        bool hit = false;
+        if (cache && changed) {
+            cacheLookups++;
+            hit = cache->find(hash, evaluation) && (evaluation.complete || evaluation.cost > limit);
+        }
+        double newCost;
+        if (hit) {
+            cacheHits++;
+            newCost = evaluation.cost;
+        } else {
+            if (changed) tree->packFloorplan(blocks);
+            newCost = _floorplanner->calcCost(limit);
+            evaluation.cost = newCost;
+            evaluation.complete = newCost <= limit;
+            evaluation.area = evaluation.complete ? _floorplanner->getLastArea() : 0;
+            evaluation.wirelength = evaluation.complete ? _floorplanner->getLastWirelength() : 0;
+            evaluation.valid = -1;
+        }
+        bool costAccepted = newCost <= currentCost || newCost < threshold;
+        if (hit && costAccepted) tree->packFloorplan(blocks);
+
+        if ((costAccepted || archive != nullptr) && evaluation.valid < 0)
+            evaluation.valid = checkOutlineValidity() && !checkOverlap();
+        if (cache && changed && (!hit || costAccepted)) cache->store(hash, evaluation);
+        // the cost does not see the outline, so with stayInOutline a chain that has reached
+        // a legal floorplan rejects moves that would leave the outline again
+        bool accepted = costAccepted && !(stayInOutline && foundValidSolution && evaluation.valid == 0);
+        bool isValid = (accepted || archive != nullptr) && evaluation.valid == 1;
 
-        bool isValid = checkOutlineValidity() && !checkOverlap();
         if (isValid) {
-            validSolutions++;
-            foundValidSolution = true;
+            if (validSolutions++ == 0 && firstValidTime < 0)
+                firstValidTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            // the front is reported in plain HPWL, not the weighted net model
+            if (archive != nullptr)
+                archive->insert(evaluation.area, _floorplanner->calcExactW(_floorplanner->manager._nets), blocks);
         }
         
         // solution acceptance
-        if (acceptSolution(newCost, currentCost, temperature)) {
-            currentBlocks = blocks;
-            currentTree = *tree;
+        if (accepted) {
             currentCost = newCost;
             acceptedMoves++;
             
             if (isValid && newCost < bestCost) {
+                foundValidSolution = true;
                 bestCost = newCost;
-                bestBlocks = blocks;
-                bestTree = *tree;
+                saveGeometry(blocks, bestGeometry);
+                tree->getLinks(bestLinks);
+                if (snapshots) {
+                    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                    snapshots->record(i + 1, elapsed, newCost, evaluation.area, evaluation.wirelength, blocks);
+                }
             }
         } else {
-            blocks = originalBlocks;
-            *tree = originalTree;
+            restoreGeometry(blocks, originalGeometry);
+            tree->setLinks(originalLinks);
+            tree->setLinkHash(originalLinkHash);
+            _floorplanner->setRotationHash(originalRotations);
         }
+        schedule.record(accepted, currentCost);
         
         
-        if (i % 10000 == 0) {
-            double acceptanceRate = (double)acceptedMoves / (i + 1) * 100;
-            double validRate = (double)validSolutions / (i + 1) * 100;
-            bool currentValid = checkOutlineValidity() && !checkOverlap();
-            
-            std::cout << "Iteration " << i 
-                     << ", Current Cost: " << currentCost 
-                     << ", Best Cost: " << bestCost
-                     << ", Valid: " << currentValid
-                     << ", Temp: " << temperature
-                     << ", Accept%: " << acceptanceRate
-                     << ", Valid%: " << validRate << std::endl;
+        if (verbose && i % 10000 == 0) {
+            logProgress(i, currentCost, bestCost, checkOutlineValidity() && !checkOverlap(), temperature, acceptedMoves, validSolutions);
         }
     }
     
-    clock_t endTime = clock();
-    double runtime = ((double)(endTime - startTime)) / CLOCKS_PER_SEC;
+    unsigned long long allocations = threadAllocations() - allocationsBefore;
+    double runtime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
     
+    if (_floorplanner->continuesChain()) _floorplanner->saveChainState(runtime);
     if (foundValidSolution) {
-        blocks = bestBlocks;
-        *tree = bestTree;
-        tree->packFloorplan(blocks);
+        // bestGeometry already carries the packed coordinates
+        restoreGeometry(blocks, bestGeometry);
+        tree->setLinks(bestLinks);
+    }
+    _floorplanner->getResult().iterations = i - firstIteration;
+    _floorplanner->getResult().allocations = countsAllocations() ? (long long)allocations : -1;
+    _floorplanner->getResult().cacheLookups = cacheLookups;
+    _floorplanner->getResult().cacheHits = cacheHits;
+    _floorplanner->getResult().firstValidTime = firstValidTime;
+    _floorplanner->getResult().startCost = startCost;
+    finishRun(foundValidSolution, bestCost, currentCost, runtime, acceptedMoves, validSolutions);
+}
+
+// reports a finished run; manager._blocks must already hold the floorplan to write
+void SimulatedAnnealing::finishRun(bool foundValidSolution, double bestCost, double currentCost, double runtime, int acceptedMoves, int validSolutions)
+{
+    bool verbose = _floorplanner->isVerbose();
+    const std::string& output = _floorplanner->getOutputPath();
+    
+    if (foundValidSolution && _floorplanner->getRefineThreads() > 0) {
+        auto refineStart = std::chrono::steady_clock::now();
+        Refiner refiner(_floorplanner);
+        int moves = refiner.run(_floorplanner->getRefineThreads());
+        _floorplanner->setRefinedMoves(moves);
+        double refineTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - refineStart).count();
+        if (verbose) {
+            std::cout << "Refinement: " << moves << " moves, cost " << bestCost << " -> "
+                      << (moves > 0 ? refiner.getCost() : bestCost) << " in " << refineTime << " seconds" << std::endl;
+        }
+        if (moves > 0) bestCost = refiner.getCost();
+        runtime += refineTime;
+    }
+
+    if (foundValidSolution) {
+        _floorplanner->recordResult(bestCost, runtime, true);
         
-        std::cout << "\n=== FINAL RESULTS ===" << std::endl;
-        std::cout << "Final best valid cost: " << bestCost << std::endl;
-        std::cout << "Runtime: " << runtime << " seconds" << std::endl;
-        std::cout << "Total accepted moves: " << acceptedMoves << std::endl;
-        std::cout << "Total valid solutions found: " << validSolutions << std::endl;
+        if (verbose) {
+            std::cout << "\n=== FINAL RESULTS ===" << std::endl;
+            std::cout << "Final best valid cost: " << bestCost << std::endl;
+            std::cout << "Runtime: " << runtime << " seconds" << std::endl;
+            std::cout << "Total accepted moves: " << acceptedMoves << std::endl;
+            std::cout << "Total valid solutions found: " << validSolutions << std::endl;
+            const FloorplanResult& result = _floorplanner->getResult();
+            if (result.cacheLookups > 0) {
+                std::cout << "Evaluation cache hits: " << result.cacheHits << " of " << result.cacheLookups
+                          << " lookups (" << 100.0 * result.cacheHits / result.cacheLookups << "%)" << std::endl;
+            }
+        }
         
-        _floorplanner->recordOutput(
-            _floorplanner->manager._blocks,
-            _floorplanner->manager._nets, 
-            _floorplanner->manager._terminals,
-            bestCost,
-            runtime,
-            "output.rpt"
-        );
+        if (!output.empty()) {
+            _floorplanner->recordOutput(
+                _floorplanner->manager._blocks,
+                _floorplanner->manager._nets, 
+                _floorplanner->manager._terminals,
+                bestCost,
+                runtime,
+                output
+            );
+        }
         
-        std::cout << "Valid solution written to output.rpt" << std::endl;
+        if (verbose && !output.empty()) std::cout << "Valid solution written to " << output << std::endl;
         
     } else {
-        std::cout << "\n=== NO VALID SOLUTION FOUND ===" << std::endl;
-        std::cout << "Final current cost: " << currentCost << std::endl;
-        std::cout << "Runtime: " << runtime << " seconds" << std::endl;
-        std::cout << "Total accepted moves: " << acceptedMoves << std::endl;
+        _floorplanner->recordResult(currentCost, runtime, false);
+
+        if (verbose) {
+            std::cout << "\n=== NO VALID SOLUTION FOUND ===" << std::endl;
+            std::cout << "Final current cost: " << currentCost << std::endl;
+            std::cout << "Runtime: " << runtime << " seconds" << std::endl;
+            std::cout << "Total accepted moves: " << acceptedMoves << std::endl;
+        }
         
-        _floorplanner->recordOutput(
-            _floorplanner->manager._blocks,
-            _floorplanner->manager._nets, 
-            _floorplanner->manager._terminals,
-            currentCost,
-            runtime,
-            "output.rpt"
-        );
+        if (!output.empty()) {
+            _floorplanner->recordOutput(
+                _floorplanner->manager._blocks,
+                _floorplanner->manager._nets, 
+                _floorplanner->manager._terminals,
+                currentCost,
+                runtime,
+                output
+            );
+        }
         
-        std::cout << "Debug output written to output.rpt (INVALID SOLUTION)" << std::endl;
+        if (verbose && !output.empty()) std::cout << "Debug output written to " << output << " (INVALID SOLUTION)" << std::endl;
     }
 }
 
@@ -660,7 +1230,7 @@ bool SimulatedAnnealing::checkOverlap() {
 }
 
 bool SimulatedAnnealing::checkTreeValidity(BStarTree& tree) {
-    std::vector<TreeNode*> nodes = tree.getNodes();
+    const std::vector<TreeNode*>& nodes = tree.getNodes();
     
     for (auto node : nodes) {
         if (node == nullptr) continue;
@@ -676,13 +1246,14 @@ bool SimulatedAnnealing::checkTreeValidity(BStarTree& tree) {
     return true;
 }
 
-bool SimulatedAnnealing::acceptSolution(double newCost, double currentCost, double temperature) {
-    if (newCost <= currentCost) {
-        return true;
+// Metropolis criterion drawn ahead of evaluation: an uphill move is accepted
+// while u < exp(-(newCost - currentCost) / T), i.e. newCost < currentCost - T ln u
+double SimulatedAnnealing::acceptanceThreshold(double currentCost, double temperature) {
+    double u = _floorplanner->randUnit();
+    if (u <= 0) {
+        return DBL_MAX;
     }
-    
-    double probability = exp(-(newCost - currentCost) / temperature);
-    return (rand() / (double)RAND_MAX) < probability;
+    return currentCost - temperature * log(u);
 }
 
 int Floorplanner::recordOutput(std::vector<Block>& blocks, const std::vector<Net>& nets, const std::vector<Terminal>& terminals, double bestCost, double runtime, std::string output) {
@@ -690,21 +1261,35 @@ int Floorplanner::recordOutput(std::vector<Block>& blocks, const std::vector<Net
     int maxY;
     calculateChipDimensions(blocks, &maxX, &maxY);
     
-    std::ofstream file(output);
-    if (!file.is_open()) return false;
-    
-    file << bestCost << std::endl;
-    file << calcW(const_cast<std::vector<Net>&>(nets)) << std::endl;
-    file << maxX * maxY << std::endl;
-    file << maxX << " " << maxY << std::endl;
-    file << runtime << std::endl;
+    // the report is formatted in memory and written with a single call
+    std::ostringstream report;
+    report << bestCost << "\n";
+    report << calcExactW(const_cast<std::vector<Net>&>(nets)) << "\n";
+    report << maxX * maxY << "\n";
+    report << maxX << " " << maxY << "\n";
+    report << runtime << "\n";
     
     for (int i = 0; i < blocks.size(); i++) {
-        file << blocks[i].getName() << " " << blocks[i].getX1() << " " << blocks[i].getY1() << " " 
-             << blocks[i].getX2() << " " << blocks[i].getY2() << std::endl;
+        report << blocks[i].getName() << " " << blocks[i].getX1() << " " << blocks[i].getY1() << " " 
+             << blocks[i].getX2() << " " << blocks[i].getY2() << "\n";
     }
+    // a refined floorplan is not the packing of any B*-tree; the two-field line is
+    // skipped by readers that take five-field block lines
+    if (_refinedMoves > 0) report << "refined " << _refinedMoves << "\n";
     
-    return true;
+    std::ofstream file(output);
+    if (!file.is_open()) return false;
+    const std::string contents = report.str();
+    file.write(contents.data(), contents.size());
+    return static_cast<bool>(file);
+}
+
+void Floorplanner::recordResult(double cost, double runtime, bool valid) {
+    _result.cost = cost;
+    _result.area = calcA(manager._blocks);
+    _result.wirelength = calcExactW(manager._nets);
+    _result.runtime = runtime;
+    _result.valid = valid;
 }
 
 void Floorplanner::calculateChipDimensions(std::vector<Block>& blocks, int* maxX, int* maxY) {
@@ -0,0 +1,124 @@
+#include "initialFloorplan.h"
+#include <algorithm>
+#include <map>
+
+std::vector<int> clusterOrder(PlacementManager &manager)
+{
+    std::vector<Block> &blocks = manager._blocks;
+    int n = blocks.size();
+    std::map<const Terminal *, int> blockIndex;
+    for (int i = 0; i < n; i++)
+        blockIndex[&blocks[i]] = i;
+
+    std::vector<double> connectivity(n * n, 0.0);
+    for (Net &net : manager._nets)
+    {
+        if (net.getWeight() == 0 || net.usesChipBox())
+            continue;
+        std::vector<int> pins;
+        for (Terminal *term : net.getTermList())
+        {
+            auto block = blockIndex.find(term);
+            if (block != blockIndex.end() && std::find(pins.begin(), pins.end(), block->second) == pins.end())
+                pins.push_back(block->second);
+        }
+        if (pins.size() < 2)
+            continue;
+        double weight = net.getWeight() / (pins.size() - 1);
+        for (int a : pins)
+        {
+            for (int b : pins)
+            {
+                if (a != b)
+                    connectivity[a * n + b] += weight;
+            }
+        }
+    }
+
+    // gain[i] is the connection of block i to the placed blocks, or its total before the first pick
+    std::vector<double> gain(n, 0.0);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+            gain[i] += connectivity[i * n + j];
+    }
+    std::vector<bool> placed(n, false);
+    std::vector<int> order;
+    for (int step = 0; step < n; step++)
+    {
+        int next = -1;
+        for (int i = 0; i < n; i++)
+        {
+            if (placed[i])
+                continue;
+            if (next < 0 || gain[i] > gain[next] || (gain[i] == gain[next] && blocks[i].getArea() > blocks[next].getArea()))
+                next = i;
+        }
+        placed[next] = true;
+        order.push_back(next);
+        if (step == 0)
+            std::fill(gain.begin(), gain.end(), 0.0);
+        for (int i = 0; i < n; i++)
+            gain[i] += connectivity[i * n + next];
+    }
+    return order;
+}
+
+std::vector<int> heightOrder(std::vector<Block> &blocks)
+{
+    std::vector<int> order;
+    for (size_t i = 0; i < blocks.size(); i++)
+        order.push_back(i);
+    std::stable_sort(order.begin(), order.end(), [&blocks](int a, int b) {
+        return std::min(blocks[a].getWidth(), blocks[a].getHeight()) > std::min(blocks[b].getWidth(), blocks[b].getHeight());
+    });
+    return order;
+}
+
+int planShelves(std::vector<Block> &blocks, const std::vector<int> &order, int width, std::vector<std::vector<int>> &rows)
+{
+    rows.clear();
+    int height = 0;
+    int rowWidth = 0;
+    int rowHeight = 0;
+    for (int id : order)
+    {
+        Block &block = blocks[id];
+        int w = block.getWidth();
+        int h = block.getHeight();
+        // the upright orientation saves row width while it stays within the row
+        // height; otherwise lie flat so the row grows as little as possible
+        int tallW = std::min(w, h);
+        int tallH = std::max(w, h);
+        bool upright = rowWidth > 0 && tallH <= rowHeight && rowWidth + tallW <= width;
+        int placedW = upright ? tallW : tallH;
+        int placedH = upright ? tallH : tallW;
+        if (!upright && rowWidth > 0 && rowWidth + placedW > width)
+        {
+            // standing the block up instead would raise the whole row, so start a new one
+            height += rowHeight;
+            rowWidth = 0;
+            rowHeight = 0;
+        }
+        if (rowWidth == 0)
+            rows.push_back(std::vector<int>());
+        if (placedW != w)
+        {
+            block.setWidth(placedW);
+            block.setHeight(placedH);
+        }
+        rows.back().push_back(id);
+        rowWidth += placedW;
+        rowHeight = std::max(rowHeight, placedH);
+    }
+    height += rowHeight;
+
+    for (std::vector<int> &row : rows)
+    {
+        auto tallest = std::max_element(row.begin(), row.end(), [&blocks](int a, int b) {
+            return blocks[a].getHeight() < blocks[b].getHeight();
+        });
+        std::rotate(row.begin(), tallest, tallest + 1);
+    }
+    return height;
+}
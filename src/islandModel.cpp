@@ -0,0 +1,315 @@
+#include "islandModel.h"
+#include "simulatedAnnealing.h"
+#include "socketIO.h"
+#include "treeCodec.h"
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iomanip>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+// one island's best floorplan as exchanged over the wire
+struct IslandState
+{
+    double cost = 0;
+    bool valid = false;
+    std::string tree;
+};
+
+// valid floorplans beat invalid ones, then lower cost wins
+static bool better(const IslandState &a, const IslandState &b)
+{
+    if (a.valid != b.valid)
+        return a.valid;
+    return a.cost < b.cost;
+}
+
+static bool sendState(int fd, const std::string &tag, const IslandState &state)
+{
+    std::ostringstream header;
+    header << std::setprecision(17) << tag << " " << state.cost << " " << state.valid << " " << state.tree.size() << "\n";
+    return writeAll(fd, header.str() + state.tree);
+}
+
+static bool receiveState(int fd, const std::string &tag, IslandState &state, Deadline deadline = Deadline::max())
+{
+    std::string line;
+    if (!readLine(fd, line, deadline))
+        return false;
+    std::istringstream header(line);
+    std::string received;
+    size_t size;
+    if (!(header >> received >> state.cost >> state.valid >> size) || received != tag)
+        return false;
+    return readBytes(fd, size, state.tree, deadline);
+}
+
+static std::string scheduleName(ScheduleKind schedule)
+{
+    return schedule == LAM_SCHEDULE ? "lam" : "fastsa";
+}
+
+static std::string absolutePath(const std::string &path)
+{
+    char *resolved = realpath(path.c_str(), nullptr);
+    if (resolved == nullptr)
+        return path;
+    std::string absolute = resolved;
+    free(resolved);
+    return absolute;
+}
+
+int runIslands(const std::string &address, int islands, int localWorkers, const std::string &executable,
+               const FloorplanJob &job, int epochs, int refineThreads)
+{
+    // the JOB line separates its fields by whitespace, as batch files do
+    std::string blockPath = absolutePath(job.blockPath);
+    std::string netPath = absolutePath(job.netPath);
+    for (const std::string &path : {blockPath, netPath})
+    {
+        if (path.find_first_of(" \t\n") != std::string::npos)
+        {
+            std::cerr << "Island runs cannot pass a design path containing whitespace: \"" << path << "\"" << std::endl;
+            return 1;
+        }
+    }
+    DesignCache cache;
+    std::string error;
+    std::shared_ptr<const Design> design = cache.get(job.blockPath, job.netPath, error, job.netModel);
+    if (!design)
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    int listenFd = listenOn(address, error);
+    if (listenFd < 0)
+    {
+        std::cerr << "Cannot listen on \"" << address << "\": " << error << std::endl;
+        return 1;
+    }
+
+    std::vector<pid_t> children;
+    for (int i = 0; i < localWorkers; i++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(listenFd);
+            execlp(executable.c_str(), executable.c_str(), "--island-worker", address.c_str(), (char *)nullptr);
+            _exit(127);
+        }
+        if (pid > 0)
+            children.push_back(pid);
+    }
+
+    std::vector<int> islandFds;
+    while ((int)islandFds.size() < islands)
+    {
+        pollfd waiting = {listenFd, POLLIN, 0};
+        if (poll(&waiting, 1, ISLAND_ACCEPT_TIMEOUT * 1000) <= 0)
+            break;
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd >= 0)
+            islandFds.push_back(fd);
+    }
+    close(listenFd);
+    releaseAddress(address);
+    if ((int)islandFds.size() < islands)
+        std::cerr << "Only " << islandFds.size() << " of " << islands << " islands connected" << std::endl;
+
+    auto startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < islandFds.size(); i++)
+    {
+        std::ostringstream line;
+        line << "JOB " << epochs << " " << blockPath << " " << netPath << " "
+             << job.alpha << " " << job.seed + i << " " << job.timeBudget << " - " << scheduleName(job.schedule) << " " << formatNetModel(job.netModel)
+             << (job.stayInOutline ? " stay-in-outline" : "") << "\n";
+        writeAll(islandFds[i], line.str());
+    }
+
+    IslandState best;
+    bool haveBest = false;
+    int migrations = 0;
+    size_t migratedBytes = 0;
+    for (int epoch = 0; epoch < epochs && !islandFds.empty(); epoch++)
+    {
+        // an island's window is bounded by the job's time budget, so one still silent
+        // after it and a grace period is taken for dead
+        double limit = (job.timeBudget > 0 ? job.timeBudget : ISLAND_EPOCH_TIMEOUT) + ISLAND_RECEIVE_GRACE;
+        Deadline deadline = std::chrono::steady_clock::now() +
+                            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(limit));
+        std::vector<IslandState> states(islandFds.size());
+        std::vector<bool> alive(islandFds.size(), true);
+        for (size_t i = 0; i < islandFds.size(); i++)
+        {
+            alive[i] = receiveState(islandFds[i], "STATE", states[i], deadline);
+            if (alive[i] && (!haveBest || better(states[i], best)))
+            {
+                best = states[i];
+                haveBest = true;
+            }
+        }
+        std::vector<int> survivors;
+        for (size_t i = 0; i < islandFds.size(); i++)
+        {
+            if (!alive[i])
+            {
+                std::cerr << "An island disconnected or missed its deadline in epoch " << epoch << " and was dropped" << std::endl;
+                close(islandFds[i]);
+                continue;
+            }
+            if (epoch + 1 < epochs)
+            {
+                sendState(islandFds[i], "MIGRANT", best);
+                migratedBytes += best.tree.size();
+                migrations += better(best, states[i]);
+            }
+            survivors.push_back(islandFds[i]);
+        }
+        islandFds = survivors;
+    }
+    for (int fd : islandFds)
+    {
+        writeAll(fd, "DONE\n");
+        close(fd);
+    }
+    // a dropped local island may still be annealing; it gets the grace period to notice, then is killed
+    auto reapDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(ISLAND_RECEIVE_GRACE);
+    for (pid_t child : children)
+    {
+        while (waitpid(child, nullptr, WNOHANG) == 0)
+        {
+            if (std::chrono::steady_clock::now() > reapDeadline)
+            {
+                kill(child, SIGKILL);
+                waitpid(child, nullptr, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    if (!haveBest)
+    {
+        std::cerr << "No island reported a floorplan" << std::endl;
+        return 1;
+    }
+
+    // rebuild the global best on the shared design, then refine and report it as a normal run would
+    Floorplanner fp(job.alpha, *design);
+    fp.setVerbose(false);
+    fp.prepare();
+    if (!decodeTree(best.tree, *fp.getTree(), fp.manager._blocks))
+    {
+        std::cerr << "Malformed tree from an island" << std::endl;
+        return 1;
+    }
+    fp.getTree()->packFloorplan(fp.manager._blocks);
+    SimulatedAnnealing sa(&fp);
+    double cost = fp.calcCost();
+    bool valid = sa.checkOutlineValidity() && !sa.checkOverlap();
+    fp.setOutputPath(job.outputPath);
+    fp.setRefineThreads(refineThreads);
+    double runtime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    sa.finishRun(valid, cost, cost, runtime, 0, 0);
+    FloorplanResult &result = fp.getResult();
+    std::cout << "Islands " << islands << " epochs " << epochs << " migrations " << migrations
+              << " migrated bytes " << migratedBytes << " tree bytes " << best.tree.size() << std::endl;
+    std::cout << "cost " << result.cost << " area " << result.area << " wirelength " << result.wirelength
+              << " runtime " << result.runtime << " valid " << result.valid << std::endl;
+    return 0;
+}
+
+int runIslandWorker(const std::string &address)
+{
+    int fd = -1;
+    for (int attempt = 0; attempt < ISLAND_CONNECT_ATTEMPTS && fd < 0; attempt++)
+    {
+        fd = connectTo(address);
+        if (fd < 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (fd < 0)
+    {
+        std::cerr << "Cannot reach the coordinator at \"" << address << "\"" << std::endl;
+        return 1;
+    }
+
+    std::string line;
+    std::string tag;
+    int epochs = 0;
+    FloorplanJob job;
+    if (!readLine(fd, line))
+    {
+        close(fd);
+        return 1;
+    }
+    std::istringstream header(line);
+    std::string rest;
+    if (!(header >> tag >> epochs) || tag != "JOB" || !getline(header, rest) || !parseJob(rest, job) || epochs < 1)
+    {
+        std::cerr << "Malformed job from the coordinator: " << line << std::endl;
+        close(fd);
+        return 1;
+    }
+    DesignCache cache;
+    std::string error;
+    std::shared_ptr<const Design> design = cache.get(job.blockPath, job.netPath, error, job.netModel);
+    if (!design)
+    {
+        std::cerr << error << std::endl;
+        close(fd);
+        return 1;
+    }
+
+    Floorplanner fp(job.alpha, *design);
+    fp.setVerbose(false);
+    fp.setSeed(job.seed);
+    fp.setTimeBudget(job.timeBudget);
+    fp.setSchedule(job.schedule);
+    fp.setOutputPath("");
+    // refinement moves blocks off the tree, which would then no longer describe the state
+    fp.setRefineThreads(0);
+    // the epochs are windows of one chain, so the schedule and the current state carry over
+    fp.setContinuousChain(true);
+    fp.prepare();
+    IslandState own;
+    for (int epoch = 0; epoch < epochs; epoch++)
+    {
+        int first = (long long)NUM_ITERATIONS * epoch / epochs;
+        int last = (long long)NUM_ITERATIONS * (epoch + 1) / epochs;
+        fp.setIterationWindow(first, last - first);
+        fp.anneal();
+
+        // the window leaves its best in the tree; the island reports the best of all windows
+        IslandState window;
+        window.cost = fp.getResult().cost;
+        window.valid = fp.getResult().valid;
+        if (epoch == 0 || better(window, own))
+        {
+            window.tree = encodeTree(*fp.getTree(), fp.manager._blocks);
+            own = window;
+        }
+        if (!sendState(fd, "STATE", own))
+            break;
+        if (epoch + 1 == epochs)
+            break;
+        IslandState migrant;
+        if (!receiveState(fd, "MIGRANT", migrant))
+            break;
+        if (better(migrant, own) && decodeTree(migrant.tree, *fp.getTree(), fp.manager._blocks))
+        {
+            // the chain moves on to the migrant instead of where the window ended
+            fp.getTree()->packFloorplan(fp.manager._blocks);
+            fp.restartChain();
+            own = migrant;
+        }
+    }
+    readLine(fd, line);
+    close(fd);
+    return 0;
+}
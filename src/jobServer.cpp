@@ -0,0 +1,85 @@
+#include "jobServer.h"
+#include "socketIO.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int JobServer::run()
+{
+    std::string error;
+    int listenFd = listenOn(_socketPath, error);
+    if (listenFd < 0)
+    {
+        std::cerr << "Cannot listen on \"" << _socketPath << "\": " << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Serving on " << _socketPath << " with " << _numWorkers << " workers" << std::endl;
+    {
+        ThreadPool pool(_numWorkers);
+        while (true)
+        {
+            int clientFd = accept(listenFd, nullptr, nullptr);
+            if (clientFd < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            std::string request;
+            Deadline deadline = std::chrono::steady_clock::now() + std::chrono::seconds(JOB_SERVER_READ_TIMEOUT);
+            if (!readLine(clientFd, request, deadline))
+            {
+                close(clientFd);
+                continue;
+            }
+            if (request == "shutdown")
+            {
+                writeAll(clientFd, "OK\n");
+                close(clientFd);
+                break;
+            }
+            pool.submit([this, clientFd, request] { handleJob(clientFd, request); });
+        }
+        // pool destructor finishes the queued jobs
+    }
+    close(listenFd);
+    releaseAddress(_socketPath);
+    std::cout << "Design cache hits: " << _cache.getHits() << ", misses: " << _cache.getMisses() << std::endl;
+    return 0;
+}
+
+void JobServer::handleJob(int clientFd, const std::string &request)
+{
+    FloorplanJob job;
+    FloorplanResult result;
+    std::string error;
+    std::ostringstream response;
+    if (!parseJob(request, job))
+    {
+        response << "ERR malformed job \"" << request << "\"\n";
+    }
+    else if (!runJob(_cache, job, result, error))
+    {
+        response << "ERR " << error << "\n";
+    }
+    else
+    {
+        response << "OK " << result.cost << " " << result.area << " " << result.wirelength << " "
+                 << result.runtime << " " << result.valid << "\n";
+    }
+    writeAll(clientFd, response.str());
+    close(clientFd);
+}
+
+bool submitRequest(const std::string &socketPath, const std::string &request, std::string &response)
+{
+    int fd = connectTo(socketPath);
+    if (fd < 0)
+        return false;
+    writeAll(fd, request + "\n");
+    bool received = readLine(fd, response);
+    close(fd);
+    return received;
+}
@@ -0,0 +1,110 @@
+#include "paretoArchive.h"
+#include "designCache.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <iomanip>
+
+bool ParetoArchive::dominated(double area, double wirelength) const
+{
+    for (const ParetoEntry &entry : _entries)
+    {
+        if (entry.area <= area && entry.wirelength <= wirelength)
+            return true;
+    }
+    return false;
+}
+
+bool ParetoArchive::insert(double area, double wirelength, const std::vector<Block> &blocks)
+{
+    if (dominated(area, wirelength))
+        return false;
+    _entries.erase(std::remove_if(_entries.begin(), _entries.end(), [&](const ParetoEntry &entry) {
+                       return area <= entry.area && wirelength <= entry.wirelength;
+                   }),
+                   _entries.end());
+    auto position = std::lower_bound(_entries.begin(), _entries.end(), area, [](const ParetoEntry &entry, double value) {
+        return entry.area < value;
+    });
+    _entries.insert(position, ParetoEntry{area, wirelength, blocks});
+    return true;
+}
+
+void ParetoArchive::merge(const ParetoArchive &other)
+{
+    for (const ParetoEntry &entry : other._entries)
+    {
+        insert(entry.area, entry.wirelength, entry.blocks);
+    }
+}
+
+bool ParetoArchive::writeFront(const std::string &output) const
+{
+    std::ofstream file(output);
+    if (!file.is_open())
+        return false;
+
+    // full precision, so the front can be checked against the listed block coordinates
+    file << std::setprecision(17) << _entries.size() << "\n";
+    for (size_t i = 0; i < _entries.size(); i++)
+    {
+        file << "Solution " << i << " " << _entries[i].area << " " << _entries[i].wirelength << "\n";
+        for (const Block &block : _entries[i].blocks)
+        {
+            file << block.getName() << " " << block.getX1() << " " << block.getY1() << " "
+                 << block.getX2() << " " << block.getY2() << "\n";
+        }
+    }
+    return true;
+}
+
+int runPareto(const std::string &blockPath, const std::string &netPath, const std::string &output, int replicas, double timeBudget,
+              int numThreads, unsigned int seed)
+{
+    DesignCache cache;
+    std::string error;
+    std::shared_ptr<const Design> design = cache.get(blockPath, netPath, error);
+    if (!design)
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if (replicas < 1)
+        replicas = 1;
+
+    // every replica fills a private archive; they are merged once all finish
+    std::vector<ParetoArchive> archives(replicas);
+    {
+        ThreadPool pool(std::min(numThreads, replicas));
+        for (int i = 0; i < replicas; i++)
+        {
+            pool.submit([&, i] {
+                Floorplanner fp(replicas == 1 ? 0.5 : (i + 0.5) / replicas, *design);
+                fp.setVerbose(false);
+                fp.setSeed(seed + i);
+                fp.setTimeBudget(timeBudget);
+                fp.setOutputPath("");
+                fp.setParetoArchive(&archives[i]);
+                fp.floorplan();
+            });
+        }
+        pool.wait();
+    }
+
+    ParetoArchive front;
+    for (const ParetoArchive &archive : archives)
+    {
+        front.merge(archive);
+    }
+    if (!front.writeFront(output))
+    {
+        std::cerr << "Cannot open the output file \"" << output << "\"" << std::endl;
+        return 1;
+    }
+    std::cout << std::setprecision(17) << "Pareto front of " << front.getEntries().size() << " solutions from " << replicas
+              << " replicas written to " << output << std::endl;
+    for (const ParetoEntry &entry : front.getEntries())
+    {
+        std::cout << "  area " << entry.area << " wirelength " << entry.wirelength << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+#include "refiner.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <map>
+#include <memory>
+
+Refiner::Refiner(Floorplanner *fp) : _floorplanner(fp)
+{
+    std::vector<Block> &blocks = fp->manager._blocks;
+    std::map<const Terminal *, int> blockIndex;
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        _placement.x.push_back(blocks[i].getX1());
+        _placement.y.push_back(blocks[i].getY1());
+        _placement.width.push_back(blocks[i].getWidth());
+        _placement.height.push_back(blocks[i].getHeight());
+        blockIndex[&blocks[i]] = i;
+    }
+
+    for (Net &net : fp->manager._nets)
+    {
+        if (net.getWeight() == 0)
+            continue;
+        _netStart.push_back(_netPins.size());
+        _netWeight.push_back(net.getWeight());
+        _netChipBox.push_back(net.usesChipBox());
+        double minX = INT_MAX;
+        double minY = INT_MAX;
+        double maxX = 0.0;
+        double maxY = 0.0;
+        for (Terminal *term : net.getTermList())
+        {
+            auto block = blockIndex.find(term);
+            if (block != blockIndex.end())
+            {
+                if (!net.usesChipBox())
+                    _netPins.push_back(block->second);
+                continue;
+            }
+            minX = (term->getX1() < minX) ? term->getX1() : minX;
+            minY = (term->getY1() < minY) ? term->getY1() : minY;
+            maxX = (term->getX2() > maxX) ? term->getX2() : maxX;
+            maxY = (term->getY2() > maxY) ? term->getY2() : maxY;
+        }
+        _netBox.push_back(minX);
+        _netBox.push_back(minY);
+        _netBox.push_back(maxX);
+        _netBox.push_back(maxY);
+    }
+    _netStart.push_back(_netPins.size());
+    _cost = calcCost(_placement);
+}
+
+// same cost as Floorplanner::calcCost, including net weights and chip-box nets
+double Refiner::calcCost(const RefinePlacement &p)
+{
+    int chipWidth = 0;
+    int chipHeight = 0;
+    for (size_t i = 0; i < p.x.size(); i++)
+    {
+        chipWidth = std::max(chipWidth, p.x[i] + p.width[i]);
+        chipHeight = std::max(chipHeight, p.y[i] + p.height[i]);
+    }
+    double W = 0;
+    for (size_t net = 0; net + 1 < _netStart.size(); net++)
+    {
+        double minX = _netBox[4 * net];
+        double minY = _netBox[4 * net + 1];
+        double maxX = _netBox[4 * net + 2];
+        double maxY = _netBox[4 * net + 3];
+        if (_netChipBox[net])
+        {
+            minX = minX < 0 ? minX : 0;
+            minY = minY < 0 ? minY : 0;
+            maxX = maxX > chipWidth ? maxX : chipWidth;
+            maxY = maxY > chipHeight ? maxY : chipHeight;
+        }
+        for (int pin = _netStart[net]; pin < _netStart[net + 1]; pin++)
+        {
+            int b = _netPins[pin];
+            minX = (p.x[b] < minX) ? p.x[b] : minX;
+            minY = (p.y[b] < minY) ? p.y[b] : minY;
+            maxX = (p.x[b] + p.width[b] > maxX) ? p.x[b] + p.width[b] : maxX;
+            maxY = (p.y[b] + p.height[b] > maxY) ? p.y[b] + p.height[b] : maxY;
+        }
+        W += _netWeight[net] * ((maxX - minX) + (maxY - minY));
+    }
+    double A = (double)chipWidth * chipHeight;
+    double alpha = _floorplanner->getAlpha();
+    return alpha * (A / _floorplanner->getAnorm()) + (1.0 - alpha) * (W / _floorplanner->getWnorm());
+}
+
+// every rotation and slide, then each block's swaps with its REFINE_NEIGHBORS nearest blocks, without repeats
+std::vector<Refiner::Move> Refiner::enumerateMoves()
+{
+    const RefinePlacement &p = _placement;
+    int n = p.x.size();
+    std::vector<Move> moves;
+    for (int a = 0; a < n; a++)
+    {
+        moves.push_back({ROTATE, a, -1});
+        if (slideLimit(p, a, true) < p.x[a])
+            moves.push_back({SLIDE_LEFT, a, -1});
+        if (slideLimit(p, a, false) < p.y[a])
+            moves.push_back({SLIDE_DOWN, a, -1});
+    }
+
+    std::vector<std::pair<long long, int>> distances;
+    std::vector<bool> paired(n * n, false);
+    for (int a = 0; a < n; a++)
+    {
+        distances.clear();
+        for (int b = 0; b < n; b++)
+        {
+            if (b == a)
+                continue;
+            // doubled centers keep the distance integral
+            long long dx = (2LL * p.x[a] + p.width[a]) - (2LL * p.x[b] + p.width[b]);
+            long long dy = (2LL * p.y[a] + p.height[a]) - (2LL * p.y[b] + p.height[b]);
+            distances.emplace_back(dx * dx + dy * dy, b);
+        }
+        int k = std::min<int>(REFINE_NEIGHBORS, distances.size());
+        std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+        for (int i = 0; i < k; i++)
+        {
+            int b = distances[i].second;
+            if (paired[a * n + b])
+                continue;
+            paired[a * n + b] = paired[b * n + a] = true;
+            moves.push_back({SWAP, std::min(a, b), std::max(a, b)});
+        }
+    }
+    return moves;
+}
+
+// lowest x (or y) block can slide to before it touches a block in its way or the outline edge
+int Refiner::slideLimit(const RefinePlacement &p, int block, bool left)
+{
+    int limit = 0;
+    for (size_t i = 0; i < p.x.size(); i++)
+    {
+        if ((int)i == block)
+            continue;
+        if (left)
+        {
+            bool inWay = p.y[i] < p.y[block] + p.height[block] && p.y[block] < p.y[i] + p.height[i];
+            if (inWay && p.x[i] + p.width[i] <= p.x[block])
+                limit = std::max(limit, p.x[i] + p.width[i]);
+        }
+        else
+        {
+            bool inWay = p.x[i] < p.x[block] + p.width[block] && p.x[block] < p.x[i] + p.width[i];
+            if (inWay && p.y[i] + p.height[i] <= p.y[block])
+                limit = std::max(limit, p.y[i] + p.height[i]);
+        }
+    }
+    return limit;
+}
+
+// applies move to p and returns whether the result is legal
+bool Refiner::apply(RefinePlacement &p, const Move &move)
+{
+    int a = move.a;
+    int b = move.b;
+    switch (move.kind)
+    {
+    case ROTATE:
+        std::swap(p.width[a], p.height[a]);
+        return fits(p, a, -1);
+    case SWAP:
+        std::swap(p.x[a], p.x[b]);
+        std::swap(p.y[a], p.y[b]);
+        // the swapped pair may overlap each other when their sizes differ
+        return fits(p, a, b) && fits(p, b, a) &&
+               !(p.x[a] < p.x[b] + p.width[b] && p.x[b] < p.x[a] + p.width[a] &&
+                 p.y[a] < p.y[b] + p.height[b] && p.y[b] < p.y[a] + p.height[a]);
+    case SLIDE_LEFT:
+        p.x[a] = slideLimit(p, a, true);
+        return true;
+    case SLIDE_DOWN:
+        p.y[a] = slideLimit(p, a, false);
+        return true;
+    }
+    return false;
+}
+
+// whether block lies inside the outline without overlapping any block but other
+bool Refiner::fits(const RefinePlacement &p, int block, int other)
+{
+    int x1 = p.x[block];
+    int y1 = p.y[block];
+    int x2 = x1 + p.width[block];
+    int y2 = y1 + p.height[block];
+    if (x2 > _floorplanner->outlineWidth || y2 > _floorplanner->outlineHeight)
+        return false;
+    for (size_t i = 0; i < p.x.size(); i++)
+    {
+        if ((int)i == block || (int)i == other)
+            continue;
+        if (x1 < p.x[i] + p.width[i] && p.x[i] < x2 && y1 < p.y[i] + p.height[i] && p.y[i] < y2)
+            return false;
+    }
+    return true;
+}
+
+// costs[i] is the cost after moves[i], or DBL_MAX when the move breaks legality
+void Refiner::evaluate(const std::vector<Move> &moves, size_t begin, size_t end, std::vector<double> &costs)
+{
+    RefinePlacement p = _placement;
+    for (size_t i = begin; i < end; i++)
+    {
+        const Move &move = moves[i];
+        bool legal = apply(p, move);
+        costs[i] = legal ? calcCost(p) : DBL_MAX;
+        p.x[move.a] = _placement.x[move.a];
+        p.y[move.a] = _placement.y[move.a];
+        p.width[move.a] = _placement.width[move.a];
+        p.height[move.a] = _placement.height[move.a];
+        if (move.b >= 0)
+        {
+            p.x[move.b] = _placement.x[move.b];
+            p.y[move.b] = _placement.y[move.b];
+        }
+    }
+}
+
+int Refiner::run(int numThreads)
+{
+    std::unique_ptr<ThreadPool> pool;
+    if (numThreads > 1)
+        pool.reset(new ThreadPool(numThreads));
+
+    int applied = 0;
+    std::vector<double> costs;
+    while (applied < REFINE_MAX_MOVES)
+    {
+        std::vector<Move> moves = enumerateMoves();
+        costs.assign(moves.size(), DBL_MAX);
+        if (pool)
+        {
+            size_t chunk = (moves.size() + numThreads - 1) / numThreads;
+            for (size_t begin = 0; begin < moves.size(); begin += chunk)
+            {
+                size_t end = std::min(begin + chunk, moves.size());
+                pool->submit([&, begin, end] { evaluate(moves, begin, end, costs); });
+            }
+            pool->wait();
+        }
+        else
+        {
+            evaluate(moves, 0, moves.size(), costs);
+        }
+
+        // the first of equally cheap moves wins, keeping the descent deterministic
+        size_t best = std::min_element(costs.begin(), costs.end()) - costs.begin();
+        if (costs.empty() || costs[best] >= _cost)
+            break;
+        apply(_placement, moves[best]);
+        _cost = costs[best];
+        applied++;
+    }
+
+    std::vector<Block> &blocks = _floorplanner->manager._blocks;
+    for (size_t i = 0; applied > 0 && i < blocks.size(); i++)
+    {
+        blocks[i].setWidth(_placement.width[i]);
+        blocks[i].setHeight(_placement.height[i]);
+        blocks[i].setPos(_placement.x[i], _placement.y[i], _placement.x[i] + _placement.width[i], _placement.y[i] + _placement.height[i]);
+    }
+    return applied;
+}
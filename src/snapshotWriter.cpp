@@ -0,0 +1,89 @@
+#include "snapshotWriter.h"
+#include <cstring>
+
+template <typename T>
+static void append(std::string &bytes, T value)
+{
+    char raw[sizeof(T)];
+    memcpy(raw, &value, sizeof(T));
+    bytes.append(raw, sizeof(T));
+}
+
+SnapshotWriter::SnapshotWriter(const std::string &path, int outlineWidth, int outlineHeight, std::vector<Block> &blocks)
+    : _file(path, std::ios::out | std::ios::binary)
+{
+    if (!_file.is_open())
+        return;
+    std::string header(SNAPSHOT_MAGIC);
+    append<uint32_t>(header, SNAPSHOT_VERSION);
+    append<uint32_t>(header, outlineWidth);
+    append<uint32_t>(header, outlineHeight);
+    append<uint32_t>(header, blocks.size());
+    for (Block &block : blocks)
+    {
+        const std::string name = block.getName();
+        append<uint32_t>(header, name.size());
+        header += name;
+    }
+    _file.write(header.data(), header.size());
+    _writer = std::thread(&SnapshotWriter::writerLoop, this);
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    if (!_writer.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closing = true;
+    }
+    _pendingReady.notify_one();
+    _writer.join();
+}
+
+void SnapshotWriter::record(uint64_t iteration, double seconds, double cost, double area, double wirelength, std::vector<Block> &blocks)
+{
+    if (!_file.is_open())
+        return;
+    std::string bytes;
+    bytes.reserve(40 + blocks.size() * 16);
+    append<uint64_t>(bytes, iteration);
+    append<double>(bytes, seconds);
+    append<double>(bytes, cost);
+    append<double>(bytes, area);
+    append<double>(bytes, wirelength);
+    for (Block &block : blocks)
+    {
+        append<uint32_t>(bytes, block.getX1());
+        append<uint32_t>(bytes, block.getY1());
+        append<uint32_t>(bytes, block.getX2());
+        append<uint32_t>(bytes, block.getY2());
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending.push_back(std::move(bytes));
+    }
+    _pendingReady.notify_one();
+}
+
+void SnapshotWriter::writerLoop()
+{
+    std::vector<std::string> batch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _pendingReady.wait(lock, [this] { return _closing || !_pending.empty(); });
+            if (_pending.empty())
+                break;
+            batch.swap(_pending);
+        }
+        for (const std::string &bytes : batch)
+        {
+            _file.write(bytes.data(), bytes.size());
+        }
+        batch.clear();
+        _file.flush();
+    }
+    _file.close();
+}
@@ -0,0 +1,198 @@
+#include "socketIO.h"
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static bool isTcpAddress(const std::string &address)
+{
+    return !address.empty() && address[0] != '/' && address.find(':') != std::string::npos;
+}
+
+static bool fillAddress(const std::string &socketPath, sockaddr_un &address)
+{
+    if (socketPath.size() >= sizeof(address.sun_path))
+        return false;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    return true;
+}
+
+// removes a stale socket file at path; anything else there is left alone
+static bool removeSocketFile(const std::string &path)
+{
+    struct stat status;
+    if (lstat(path.c_str(), &status) < 0)
+        return errno == ENOENT;
+    if (!S_ISSOCK(status.st_mode))
+        return false;
+    unlink(path.c_str());
+    return true;
+}
+
+static addrinfo *resolve(const std::string &address, bool passive)
+{
+    size_t colon = address.rfind(':');
+    std::string host = address.substr(0, colon);
+    std::string port = address.substr(colon + 1);
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    addrinfo *result = nullptr;
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result) != 0)
+        return nullptr;
+    return result;
+}
+
+int listenOn(const std::string &address, std::string &error)
+{
+    if (isTcpAddress(address))
+    {
+        addrinfo *info = resolve(address, true);
+        if (info == nullptr)
+        {
+            error = "cannot resolve " + address;
+            return -1;
+        }
+        int fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        int reuse = 1;
+        if (fd >= 0)
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (fd < 0 || bind(fd, info->ai_addr, info->ai_addrlen) < 0 || listen(fd, 64) < 0)
+        {
+            error = strerror(errno);
+            if (fd >= 0)
+                close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(info);
+        return fd;
+    }
+
+    sockaddr_un unixAddress;
+    if (!fillAddress(address, unixAddress))
+    {
+        error = "socket path is too long";
+        return -1;
+    }
+    if (!removeSocketFile(address))
+    {
+        error = "the path exists and is not a socket";
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (sockaddr *)&unixAddress, sizeof(unixAddress)) < 0 || listen(fd, 64) < 0)
+    {
+        error = strerror(errno);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectTo(const std::string &address)
+{
+    if (isTcpAddress(address))
+    {
+        addrinfo *info = resolve(address, false);
+        if (info == nullptr)
+            return -1;
+        int fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd >= 0 && connect(fd, info->ai_addr, info->ai_addrlen) < 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(info);
+        return fd;
+    }
+
+    sockaddr_un unixAddress;
+    if (!fillAddress(address, unixAddress))
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (sockaddr *)&unixAddress, sizeof(unixAddress)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void releaseAddress(const std::string &address)
+{
+    if (!isTcpAddress(address))
+        removeSocketFile(address);
+}
+
+// waits until fd has data or deadline passes
+static bool waitReadable(int fd, Deadline deadline)
+{
+    if (deadline == Deadline::max())
+        return true;
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    if (remaining.count() < 0)
+        return false;
+    pollfd waiting = {fd, POLLIN, 0};
+    int ready;
+    do
+        ready = poll(&waiting, 1, (int)remaining.count());
+    while (ready < 0 && errno == EINTR);
+    return ready > 0;
+}
+
+bool readLine(int fd, std::string &line, Deadline deadline)
+{
+    line.clear();
+    char c;
+    while (true)
+    {
+        if (!waitReadable(fd, deadline))
+            return false;
+        if (read(fd, &c, 1) != 1)
+            break;
+        if (c == '\n')
+            return true;
+        line += c;
+    }
+    return !line.empty();
+}
+
+bool readBytes(int fd, size_t size, std::string &data, Deadline deadline)
+{
+    data.resize(size);
+    size_t received = 0;
+    while (received < size)
+    {
+        if (!waitReadable(fd, deadline))
+            return false;
+        ssize_t n = read(fd, &data[received], size - received);
+        if (n <= 0)
+            return false;
+        received += n;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const std::string &data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+#include "temperatureSchedule.h"
+#include <cfloat>
+#include <cmath>
+
+TemperatureSchedule::TemperatureSchedule(SimulatedAnnealing &sa, ScheduleKind kind, int maxIterations)
+    : _sa(sa), _kind(kind), _maxIterations(maxIterations), _lowestCost(DBL_MAX)
+{
+    // both schedules start where Fast-SA does, accepting an average uphill move with probability FAST_SA_P
+    _initialTemperature = sa.fastSATemperature(1);
+    _temperature = _initialTemperature;
+    // moves that leave the cost unchanged are always accepted, so late targets can be
+    // unreachable; the temperature then bottoms out where Fast-SA ends instead of underflowing
+    _finalTemperature = sa.fastSATemperature(maxIterations);
+}
+
+// Lam's target acceptance rate: 1.0 falling to 0.44 over the first 15% of the
+// run, held at 0.44 until 65%, then falling towards 0 for the rest
+void TemperatureSchedule::updateTarget()
+{
+    double f = progress();
+    if (f < 0.15)
+        _targetRate = 0.44 + 0.56 * pow(560.0, -f / 0.15);
+    else if (f < 0.65)
+        _targetRate = 0.44;
+    else
+        _targetRate = 0.44 * pow(440.0, -(f - 0.65) / 0.35);
+}
+
+void TemperatureSchedule::reheat()
+{
+    _temperature = std::min(_temperature * LAM_REHEAT, _initialTemperature);
+    _lastImprovement = _iteration;
+    _reheats++;
+}
@@ -0,0 +1,64 @@
+#include "threadPool.h"
+
+ThreadPool::ThreadPool(int numThreads)
+{
+    if (numThreads < 1)
+        numThreads = 1;
+    for (int i = 0; i < numThreads; i++)
+    {
+        _workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _taskReady.notify_all();
+    for (std::thread &worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push(std::move(task));
+    }
+    _taskReady.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this] { return _tasks.empty() && _running == 0; });
+}
+
+// workers keep draining queued tasks after stop is requested
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _taskReady.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+            if (_tasks.empty())
+                return;
+            task = std::move(_tasks.front());
+            _tasks.pop();
+            _running++;
+        }
+        task();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running--;
+            if (_tasks.empty() && _running == 0)
+                _idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#include "treeCodec.h"
+#include <algorithm>
+
+static int idBits(int count)
+{
+    int bits = 1;
+    while ((1 << bits) < count)
+        bits++;
+    return bits;
+}
+
+static void writeBits(std::string &data, size_t &bit, unsigned value, int width)
+{
+    for (int i = 0; i < width; i++, bit++)
+    {
+        if (bit / 8 >= data.size())
+            data.push_back(0);
+        if (value & (1u << i))
+            data[bit / 8] |= (char)(1 << (bit % 8));
+    }
+}
+
+static bool readBits(const std::string &data, size_t &bit, int width, unsigned &value)
+{
+    value = 0;
+    for (int i = 0; i < width; i++, bit++)
+    {
+        if (bit / 8 >= data.size())
+            return false;
+        if (data[bit / 8] & (1 << (bit % 8)))
+            value |= 1u << i;
+    }
+    return true;
+}
+
+std::string encodeTree(BStarTree &tree, std::vector<Block> &blocks)
+{
+    int count = blocks.size();
+    std::string data;
+    data.push_back((char)(count & 0xff));
+    data.push_back((char)(count >> 8));
+    size_t bit = 16;
+    int width = idBits(count);
+    std::vector<TreeNode *> stack;
+    if (tree.getRoot() != nullptr)
+        stack.push_back(tree.getRoot());
+    while (!stack.empty())
+    {
+        TreeNode *node = stack.back();
+        stack.pop_back();
+        Block &block = blocks[node->blockID];
+        writeBits(data, bit, node->blockID, width);
+        writeBits(data, bit, node->left != nullptr, 1);
+        writeBits(data, bit, node->right != nullptr, 1);
+        writeBits(data, bit, block.getHeight() > block.getWidth(), 1);
+        // right is pushed first so the left subtree is written first
+        if (node->right != nullptr)
+            stack.push_back(node->right);
+        if (node->left != nullptr)
+            stack.push_back(node->left);
+    }
+    return data;
+}
+
+bool decodeTree(const std::string &data, BStarTree &tree, std::vector<Block> &blocks)
+{
+    if (data.size() < 2)
+        return false;
+    int count = (unsigned char)data[0] | ((unsigned char)data[1] << 8);
+    if (count != (int)blocks.size() || count == 0)
+        return false;
+    int width = idBits(count);
+    size_t bit = 16;
+    std::vector<int> links(3 * count, -1);
+    std::vector<bool> seen(count, false);
+    std::vector<bool> upright(count, false);
+    // each entry is a node still waiting for a child: id * 2 + 1 for its right slot, id * 2 for its left
+    std::vector<int> pending;
+    for (int decoded = 0; decoded < count; decoded++)
+    {
+        unsigned id, hasLeft, hasRight, standing;
+        if (!readBits(data, bit, width, id) || !readBits(data, bit, 1, hasLeft) ||
+            !readBits(data, bit, 1, hasRight) || !readBits(data, bit, 1, standing))
+            return false;
+        if ((int)id >= count || seen[id] || (decoded > 0 && pending.empty()))
+            return false;
+        seen[id] = true;
+        upright[id] = standing;
+        if (decoded > 0)
+        {
+            int slot = pending.back();
+            pending.pop_back();
+            int parent = slot / 2;
+            links[3 * id] = parent;
+            links[3 * parent + 1 + slot % 2] = id;
+        }
+        if (hasRight)
+            pending.push_back(2 * id + 1);
+        if (hasLeft)
+            pending.push_back(2 * id);
+    }
+    if (!pending.empty())
+        return false;
+
+    tree.setLinks(links);
+    for (int i = 0; i < count; i++)
+    {
+        int shortSide = std::min(blocks[i].getWidth(), blocks[i].getHeight());
+        int longSide = std::max(blocks[i].getWidth(), blocks[i].getHeight());
+        blocks[i].setWidth(upright[i] ? shortSide : longSide);
+        blocks[i].setHeight(upright[i] ? longSide : shortSide);
+    }
+    return true;
+}
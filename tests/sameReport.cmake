@@ -0,0 +1,19 @@
+# runs fp twice on one design, first with the FIRST options and then with the
+# SECOND ones, and fails unless the two reports agree on every line but the runtime
+#   cmake -DFP=<fp> -DBLOCK=<block file> -DNETS=<net file> -DOUTPUT=<report prefix>
+#         -DFIRST=<options> -DSECOND=<options> -P sameReport.cmake
+foreach(run FIRST SECOND)
+    separate_arguments(options UNIX_COMMAND "${${run}}")
+    execute_process(COMMAND ${FP} ${options} 0.5 ${BLOCK} ${NETS} ${OUTPUT}_${run}.rpt
+        RESULT_VARIABLE result OUTPUT_QUIET)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "fp ${${run}} failed with ${result}")
+    endif()
+    file(STRINGS ${OUTPUT}_${run}.rpt lines)
+    # the fifth line is the runtime
+    list(REMOVE_AT lines 4)
+    set(report_${run} "${lines}")
+endforeach()
+if(NOT report_FIRST STREQUAL report_SECOND)
+    message(FATAL_ERROR "fp ${FIRST} and fp ${SECOND} wrote different floorplans")
+endif()